@@ -23,7 +23,7 @@ mingw {
     INCLUDEPATH += C:\msys64\mingw64\include\freetype2
 
     LIBS += -lmingw32 -lSDL2main -lSDL2.dll
-    LIBS += -lSDL2_image.dll -lfreetype.dll -lpcre.dll -lpng.dll -lglew32.dll -lopengl32 -lglu32
+    LIBS += -lSDL2_image.dll -lfreetype.dll -lpcre.dll -lpng.dll -lz.dll -lglew32.dll -lopengl32 -lglu32
     LIBS += -static-libgcc -static-libstdc++
     LIBS += -lcomdlg32
 }
@@ -35,23 +35,35 @@ linux {
                    /usr/include/freetype2 \
                    /usr/include
 
-    LIBS += -lGL -lGLU -lfreetype -lpcre -lGLEW -lGLU -lGL -lSDL2_image -lSDL2 -lpng12
+    LIBS += -lGL -lGLU -lfreetype -lpcre -lGLEW -lGLU -lGL -lSDL2_image -lSDL2 -lpng12 -lz -lpthread
 }
 
 VPATH += ./src
 
-SOURCES += custom.cpp \
+SOURCES += accesslogregistry.cpp \
+    compressedlog.cpp \
+    custom.cpp \
+    interntable.cpp \
+    jsonlog.cpp \
+    linebuffer.cpp \
+    linescanner.cpp \
     logentry.cpp \
+    logreader.cpp \
     logstalgia.cpp \
     main.cpp \
+    mappedlog.cpp \
     ncsa.cpp \
     paddle.cpp \
     requestball.cpp \
+    requestwindow.cpp \
+    seekablelog.cpp \
     settings.cpp \
     slider.cpp \
     summarizer.cpp \
+    summarizerpool.cpp \
     textarea.cpp \
     src/tests.cpp \
+    src/benchmark.cpp \
     configwatcher.cpp \
     core/conffile.cpp \
     core/display.cpp \
@@ -75,18 +87,31 @@ SOURCES += custom.cpp \
     core/vbo.cpp \
     core/vectors.cpp
 
-HEADERS += custom.h \
+HEADERS += accesslogregistry.h \
+    compressedlog.h \
+    custom.h \
+    interntable.h \
+    jsonlog.h \
+    linebuffer.h \
+    linescanner.h \
     logentry.h \
+    logreader.h \
     logstalgia.h \
+    mappedlog.h \
     ncsa.h \
     paddle.h \
     requestball.h \
+    requestwindow.h \
+    ringqueue.h \
+    seekablelog.h \
     settings.h \
     slider.h \
     summarizer.h \
+    summarizerpool.h \
     textarea.h \
     configwatcher.h \
     src/tests.h \
+    src/benchmark.h \
     core/bounds.h \
     core/conffile.h \
     core/display.h \
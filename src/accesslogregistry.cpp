@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "accesslogregistry.h"
+#include "ncsa.h"
+#include "custom.h"
+#include "jsonlog.h"
+
+//AccessLogFormat
+
+AccessLogFormat::AccessLogFormat(const std::string& name, AccessLogFactory factory)
+    : name(name), factory(factory) {
+}
+
+//AccessLogRegistry
+
+static AccessLog* ls_create_ncsa_log() {
+    return new NCSALog();
+}
+
+static AccessLog* ls_create_custom_log() {
+    return new CustomAccessLog();
+}
+
+static AccessLog* ls_create_json_log() {
+    return new JSONLog();
+}
+
+std::vector<AccessLogFormat>& AccessLogRegistry::getFormats() {
+
+    static std::vector<AccessLogFormat> formats = {
+        AccessLogFormat("ncsa",   ls_create_ncsa_log),
+        AccessLogFormat("custom", ls_create_custom_log),
+        AccessLogFormat("json",   ls_create_json_log)
+    };
+
+    return formats;
+}
+
+void AccessLogRegistry::registerFormat(const std::string& name, AccessLogFactory factory) {
+
+    std::vector<AccessLogFormat>& formats = getFormats();
+
+    for(AccessLogFormat& format : formats) {
+        if(format.name == name) {
+            format.factory = factory;
+            return;
+        }
+    }
+
+    formats.push_back(AccessLogFormat(name, factory));
+}
+
+std::vector<std::string> AccessLogRegistry::getFormatNames() {
+
+    std::vector<std::string> names;
+
+    for(const AccessLogFormat& format : getFormats()) {
+        names.push_back(format.name);
+    }
+
+    return names;
+}
+
+bool AccessLogRegistry::hasFormat(const std::string& name) {
+
+    for(const AccessLogFormat& format : getFormats()) {
+        if(format.name == name) return true;
+    }
+
+    return false;
+}
+
+AccessLog* AccessLogRegistry::create(const std::string& name) {
+
+    for(const AccessLogFormat& format : getFormats()) {
+        if(format.name == name) return format.factory();
+    }
+
+    return 0;
+}
+
+std::vector<AccessLog*> AccessLogRegistry::createAll() {
+
+    std::vector<AccessLog*> parsers;
+
+    for(const AccessLogFormat& format : getFormats()) {
+        parsers.push_back(format.factory());
+    }
+
+    return parsers;
+}
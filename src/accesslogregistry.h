@@ -0,0 +1,56 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ACCESS_LOG_REGISTRY_H
+#define ACCESS_LOG_REGISTRY_H
+
+#include "logentry.h"
+
+#include <string>
+#include <vector>
+
+typedef AccessLog* (*AccessLogFactory)();
+
+class AccessLogFormat {
+public:
+    AccessLogFormat(const std::string& name, AccessLogFactory factory);
+
+    std::string name;
+    AccessLogFactory factory;
+};
+
+// supported access log formats. formats are tried in the order they were
+// registered when detecting the format of a log
+
+class AccessLogRegistry {
+    static std::vector<AccessLogFormat>& getFormats();
+public:
+    static void registerFormat(const std::string& name, AccessLogFactory factory);
+
+    static std::vector<std::string> getFormatNames();
+
+    static bool hasFormat(const std::string& name);
+
+    // new parser for the named format, or 0 if there is no such format
+    static AccessLog* create(const std::string& name);
+
+    // new parser for every registered format
+    static std::vector<AccessLog*> createAll();
+};
+
+#endif
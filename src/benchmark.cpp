@@ -0,0 +1,540 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmark.h"
+#include "ncsa.h"
+#include "custom.h"
+#include "jsonlog.h"
+#include "settings.h"
+#include "linescanner.h"
+#include "summarizer.h"
+#include "summarizerpool.h"
+#include "requestball.h"
+
+#include "core/sdlapp.h"
+#include "core/texture.h"
+
+const char* ls_benchmark_methods[] = { "GET", "GET", "GET", "POST", "HEAD" };
+const char* ls_benchmark_codes[]   = { "200", "200", "200", "304", "404", "500" };
+const char* ls_benchmark_paths[]   = { "/", "/index.html", "/images/cat.jpg", "/images/dog.png", "/css/style.css", "/js/app.js", "/api/v1/users", "/blog/2019/03/release.html" };
+
+LogstalgiaBenchmark::LogstalgiaBenchmark() {
+}
+
+// synthetic log lines with some variation in each field.
+// the same requests are generated in combined, custom and json format
+void LogstalgiaBenchmark::generateLines(int count) {
+
+    ncsa_lines.clear();
+    ncsa_lines.reserve(count);
+
+    custom_lines.clear();
+    custom_lines.reserve(count);
+
+    json_lines.clear();
+    json_lines.reserve(count);
+
+    char hostname[64];
+    char buff[1024];
+
+    for(int i=0;i<count;i++) {
+
+        int second = i % 60;
+        int minute = (i / 60) % 60;
+        int hour   = (i / 3600) % 24;
+
+        snprintf(hostname, 64, "%d.%d.%d.%d", 10 + (i % 7), (i / 7) % 256, (i / 13) % 256, i % 256);
+
+        const char* method = ls_benchmark_methods[i % 5];
+        const char* path   = ls_benchmark_paths[i % 8];
+        const char* code   = ls_benchmark_codes[i % 6];
+        int size           = (i * 37) % 100000;
+
+        snprintf(buff, 1024, "%s - - [22/Apr/2019:%02d:%02d:%02d +1200] \"%s %s HTTP/1.1\" %s %d \"http://www.example.com/\" \"Mozilla/5.0 (X11; Linux x86_64)\"",
+            hostname, hour, minute, second, method, path, code, size);
+
+        ncsa_lines.push_back(std::string(buff));
+
+        snprintf(buff, 1024, "%d|%s|%s|%s|%d||||Mozilla/5.0 (X11; Linux x86_64)",
+            1555891200 + hour * 3600 + minute * 60 + second, hostname, path, code, size);
+
+        custom_lines.push_back(std::string(buff));
+
+        snprintf(buff, 1024, "{\"time\":\"2019-04-22T%02d:%02d:%02d+12:00\",\"remote_addr\":\"%s\",\"request\":\"%s %s HTTP/1.1\",\"status\":%s,\"body_bytes_sent\":%d,\"http_referer\":\"http://www.example.com/\",\"http_user_agent\":\"Mozilla/5.0 (X11; Linux x86_64)\"}",
+            hour, minute, second, hostname, method, path, code, size);
+
+        json_lines.push_back(std::string(buff));
+    }
+}
+
+void LogstalgiaBenchmark::report(const char* name, int count, unsigned int ms) {
+
+    double seconds = ms / 1000.0;
+    double rate = seconds > 0.0 ? count / seconds : 0.0;
+
+    printf("%-32s %8d in %6u ms  %12.0f per second\n", name, count, ms, rate);
+}
+
+void LogstalgiaBenchmark::benchmarkNCSAParser() {
+
+    NCSALog ncsalog;
+    LogEntry entry;
+
+    int count = ncsa_lines.size();
+    int parsed;
+
+    // tokenizer (with regex fallback)
+
+    parsed = 0;
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<count;i++) {
+        if(ncsalog.parseLine(ncsa_lines[i], entry)) parsed++;
+    }
+
+    report("ncsa tokenizer", parsed, SDL_GetTicks() - start_ticks);
+
+    // tokenizer allocating and keeping each entry as readLog does
+
+    std::vector<LogEntry*> entries;
+    entries.reserve(count);
+
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<count;i++) {
+        LogEntry* le = new LogEntry();
+        if(ncsalog.parseLine(ncsa_lines[i], *le)) entries.push_back(le);
+        else delete le;
+    }
+
+    report("ncsa tokenizer (queued)", entries.size(), SDL_GetTicks() - start_ticks);
+
+    printf("%-32s %8d total %8d unique\n", "interned strings", (int) intern_table.getTotalCount(), (int) intern_table.getUniqueCount());
+
+    for(LogEntry* le : entries) {
+        delete le;
+    }
+
+    // regular expressions only
+
+    parsed = 0;
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<count;i++) {
+        if(ncsalog.parseLineRegex(ncsa_lines[i], entry)) parsed++;
+    }
+
+    report("ncsa regex", parsed, SDL_GetTicks() - start_ticks);
+}
+
+void LogstalgiaBenchmark::benchmarkParser(const char* name, AccessLog& accesslog, std::vector<std::string>& lines) {
+
+    LogEntry entry;
+
+    int count  = lines.size();
+    int parsed = 0;
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<count;i++) {
+        if(accesslog.parseLine(lines[i], entry)) parsed++;
+    }
+
+    report(name, parsed, SDL_GetTicks() - start_ticks);
+}
+
+void LogstalgiaBenchmark::benchmarkTimestampFormatting() {
+
+    LogEntry entry;
+    std::string value;
+
+    // consecutive entries mostly share the same minute
+
+    int count = 1000000;
+
+    time_t start_timestamp = 1555891200;
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<count;i++) {
+        entry.timestamp = start_timestamp + i / 10;
+        entry.getValue("timestamp", value);
+    }
+
+    report("timestamp formatting", count, SDL_GetTicks() - start_ticks);
+}
+
+// high bit filtering and trimming of each line with and without vector instructions
+void LogstalgiaBenchmark::benchmarkLineFilter() {
+
+    std::vector<std::string> lines = ncsa_lines;
+
+    int count = 0;
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<10;i++) {
+        for(std::string& line : lines) {
+            count += LineScanner::filterLineScalar(&line[0], line.size()) > 0;
+        }
+    }
+
+    report("line filter (scalar)", count, SDL_GetTicks() - start_ticks);
+
+    std::string name = std::string("line filter (") + LineScanner::getInstructionSet() + ")";
+
+    count = 0;
+
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<10;i++) {
+        for(std::string& line : lines) {
+            count += LineScanner::filterLine(&line[0], line.size()) > 0;
+        }
+    }
+
+    report(name.c_str(), count, SDL_GetTicks() - start_ticks);
+}
+
+// paths added and removed as balls arrive and leave, summarized in between
+void LogstalgiaBenchmark::benchmarkSummarizer() {
+
+    FXFont font = fontmanager.grab("FreeMonoBold.ttf", settings.font_size, 72, FT_LOAD_NO_HINTING);
+
+    Summarizer summarizer(font, 100, settings.path_max_depth, settings.path_abbr_depth, 2.0f);
+    summarizer.addDelimiter('/');
+    summarizer.setSize(0, 0, 0);
+
+    int count = 100000;
+
+    std::vector<std::string> paths;
+    paths.reserve(count);
+
+    char buff[256];
+
+    for(int i=0;i<count;i++) {
+        snprintf(buff, 256, "%s/%d/page-%d.html", ls_benchmark_paths[i % 8], (i / 8) % 100, i);
+        paths.push_back(std::string(buff));
+    }
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(const std::string& path : paths) {
+        summarizer.addString(path);
+    }
+
+    report("summarizer insert", count, SDL_GetTicks() - start_ticks);
+
+    int summaries = 20;
+
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<summaries;i++) {
+        summarizer.summarize();
+    }
+
+    report("summarizer summarize", summaries, SDL_GetTicks() - start_ticks);
+
+    // a few requests arriving and leaving between each summary
+
+    int updates = 500;
+
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<updates;i++) {
+        for(int j=0;j<20;j++) {
+            const std::string& path = paths[(i * 20 + j) % count];
+
+            summarizer.removeString(path);
+            summarizer.addString(path);
+        }
+
+        summarizer.summarize();
+    }
+
+    report("summarizer update", updates, SDL_GetTicks() - start_ticks);
+
+    start_ticks = SDL_GetTicks();
+
+    for(const std::string& path : paths) {
+        summarizer.removeString(path);
+    }
+
+    report("summarizer remove", count, SDL_GetTicks() - start_ticks);
+}
+
+// a few requests arriving and leaving each group between summaries
+static void touchSummarizers(std::vector<Summarizer*>& summarizers, int pass) {
+
+    char buff[256];
+
+    for(size_t i=0;i<summarizers.size();i++) {
+        for(int j=0;j<20;j++) {
+            int n = pass * 20 + j;
+
+            snprintf(buff, 256, "%s/%d/page-%d.html", ls_benchmark_paths[(i + n) % 8], (n / 8) % 100, n);
+
+            summarizers[i]->removeString(buff);
+            summarizers[i]->addString(buff);
+        }
+    }
+}
+
+// summarize a set of groups one after the other and then on the summarizer pool
+void LogstalgiaBenchmark::benchmarkSummarizerPool() {
+
+    FXFont font = fontmanager.grab("FreeMonoBold.ttf", settings.font_size, 72, FT_LOAD_NO_HINTING);
+
+    int groups = 8;
+    int count  = 20000;
+
+    std::vector<Summarizer*> summarizers;
+
+    char buff[256];
+
+    for(int i=0;i<groups;i++) {
+        Summarizer* summarizer = new Summarizer(font, 100 / groups, settings.path_max_depth, settings.path_abbr_depth, 2.0f);
+        summarizer->addDelimiter('/');
+        summarizer->setSize(0, 0, 0);
+
+        for(int j=0;j<count;j++) {
+            snprintf(buff, 256, "%s/%d/page-%d.html", ls_benchmark_paths[(i + j) % 8], (j / 8) % 100, j);
+            summarizer->addString(std::string(buff));
+        }
+
+        summarizers.push_back(summarizer);
+    }
+
+    int passes = 50;
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<passes;i++) {
+        touchSummarizers(summarizers, i);
+
+        for(Summarizer* summarizer : summarizers) {
+            summarizer->summarize();
+        }
+    }
+
+    report("summarizer groups serial", passes, SDL_GetTicks() - start_ticks);
+
+    SummarizerPool pool;
+
+    start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<passes;i++) {
+        touchSummarizers(summarizers, i);
+
+        pool.summarize(summarizers);
+    }
+
+    snprintf(buff, 256, "summarizer groups pool (%d threads)", pool.getThreadCount() + 1);
+    report(buff, passes, SDL_GetTicks() - start_ticks);
+
+    for(Summarizer* summarizer : summarizers) {
+        delete summarizer;
+    }
+}
+
+// proxy log where every path is an absolute url, summarized with the url prefix hidden
+void LogstalgiaBenchmark::benchmarkAbsoluteURLs() {
+
+    int count = 100000;
+
+    std::vector<std::string> lines;
+    lines.reserve(count);
+
+    char buff[1024];
+
+    for(int i=0;i<count;i++) {
+        snprintf(buff, 1024, "10.0.%d.%d - - [22/Apr/2019:%02d:%02d:%02d +1200] \"GET http://www%d.example.com%s HTTP/1.1\" 200 %d",
+            (i / 256) % 256, i % 256, (i / 3600) % 24, (i / 60) % 60, i % 60, i % 16, ls_benchmark_paths[i % 8], (i * 37) % 100000);
+
+        lines.push_back(std::string(buff));
+    }
+
+    bool hide_url_prefix = settings.hide_url_prefix;
+    settings.hide_url_prefix = true;
+
+    NCSALog ncsalog;
+
+    std::vector<LogEntry*> entries;
+    entries.reserve(count);
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(std::string& line : lines) {
+        LogEntry* le = new LogEntry();
+        if(ncsalog.parseLine(line, *le)) entries.push_back(le);
+        else delete le;
+    }
+
+    report("ncsa absolute urls", entries.size(), SDL_GetTicks() - start_ticks);
+
+    settings.hide_url_prefix = hide_url_prefix;
+
+    FXFont font = fontmanager.grab("FreeMonoBold.ttf", settings.font_size, 72, FT_LOAD_NO_HINTING);
+
+    Summarizer summarizer(font, 100, settings.path_max_depth, settings.path_abbr_depth, 2.0f);
+    summarizer.addDelimiter('/');
+    summarizer.setSize(0, 0, 0);
+
+    // each request is added, positioned and removed as it would be by a ball
+
+    start_ticks = SDL_GetTicks();
+
+    for(LogEntry* le : entries) {
+        summarizer.addString(le->display_path);
+    }
+
+    summarizer.summarize();
+
+    float y = 0.0f;
+
+    for(LogEntry* le : entries) {
+        y += summarizer.getMiddlePosY(le->display_path.str());
+    }
+
+    for(LogEntry* le : entries) {
+        summarizer.removeString(le->display_path);
+    }
+
+    report("summarizer absolute urls", entries.size(), SDL_GetTicks() - start_ticks);
+
+    for(LogEntry* le : entries) {
+        delete le;
+    }
+}
+
+static void addBenchmarkBall(RequestBalls& balls, int i) {
+
+    LogEntry* le = new LogEntry();
+    le->response_size = (i * 37) % 100000;
+    le->successful    = (i % 6) < 4;
+
+    vec2 start = vec2(-(float)((i * 13) % display.width), (i * 7) % display.height);
+    vec2 dest  = vec2(display.width - 100, (i * 11) % display.height);
+
+    balls.add(le, InternedString(), vec3(1.0f, 1.0f, 1.0f), start, dest);
+}
+
+// frames of a number of balls in flight. finished balls are replaced by new ones.
+// balls are drawn one at a time with the fixed function pipeline, or from vertex buffers
+void LogstalgiaBenchmark::benchmarkRequestBalls(int count, bool ffp) {
+
+    FXFont font = fontmanager.grab("FreeMonoBold.ttf", settings.font_size, 72, FT_LOAD_NO_HINTING);
+
+    TextureResource* balltex = texturemanager.grab("ball.tga");
+    TextureResource* glowtex = texturemanager.grab("glow.tga");
+
+    quadbuf ball_vbo;
+    quadbuf glow_vbo;
+
+    RequestBalls balls;
+
+    int spawned = 0;
+
+    while(balls.size() < count) {
+        addBenchmarkBall(balls, spawned++);
+    }
+
+    int frames = std::max(10, 1000000 / count);
+
+    glEnable(GL_BLEND);
+    glEnable(GL_TEXTURE_2D);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    unsigned int start_ticks = SDL_GetTicks();
+
+    for(int i=0;i<frames;i++) {
+
+        balls.logic(1.0f / 60.0f);
+
+        for(size_t j=0; j<balls.size();) {
+            if(balls.isFinished(j)) {
+                balls.remove(j);
+            } else {
+                j++;
+            }
+        }
+
+        while(balls.size() < count) {
+            addBenchmarkBall(balls, spawned++);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, balltex->textureid);
+
+        if(ffp) {
+            balls.draw();
+        } else {
+            balls.updateVBO(ball_vbo, balltex->textureid);
+            ball_vbo.draw();
+        }
+
+        balls.drawResponseCodes(&font);
+
+        glBindTexture(GL_TEXTURE_2D, glowtex->textureid);
+
+        if(ffp) {
+            balls.drawGlow();
+        } else {
+            balls.updateGlowVBO(glow_vbo, glowtex->textureid);
+            glow_vbo.draw();
+        }
+    }
+
+    glFinish();
+
+    char buff[256];
+    snprintf(buff, 256, "request ball frames (%d balls%s)", count, ffp ? ", ffp" : "");
+
+    report(buff, frames, SDL_GetTicks() - start_ticks);
+}
+
+void LogstalgiaBenchmark::run() {
+
+    generateLines(200000);
+
+    benchmarkNCSAParser();
+
+    CustomAccessLog customlog;
+    benchmarkParser("custom", customlog, custom_lines);
+
+    JSONLog jsonlog;
+    benchmarkParser("json", jsonlog, json_lines);
+
+    benchmarkTimestampFormatting();
+
+    benchmarkLineFilter();
+
+    benchmarkSummarizer();
+
+    benchmarkSummarizerPool();
+
+    benchmarkAbsoluteURLs();
+
+    benchmarkRequestBalls(1000, true);
+    benchmarkRequestBalls(10000, true);
+    benchmarkRequestBalls(100000, true);
+
+    if(!settings.ffp) {
+        benchmarkRequestBalls(1000, false);
+        benchmarkRequestBalls(10000, false);
+        benchmarkRequestBalls(100000, false);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_BENCHMARK_H
+#define LOGSTALGIA_BENCHMARK_H
+
+#include "logentry.h"
+
+#include <string>
+#include <vector>
+
+class LogstalgiaBenchmark {
+protected:
+    std::vector<std::string> ncsa_lines;
+    std::vector<std::string> custom_lines;
+    std::vector<std::string> json_lines;
+
+    void generateLines(int count);
+
+    void report(const char* name, int count, unsigned int ms);
+
+    void benchmarkNCSAParser();
+    void benchmarkParser(const char* name, AccessLog& accesslog, std::vector<std::string>& lines);
+    void benchmarkTimestampFormatting();
+    void benchmarkLineFilter();
+    void benchmarkSummarizer();
+    void benchmarkSummarizerPool();
+    void benchmarkAbsoluteURLs();
+    void benchmarkRequestBalls(int count, bool ffp);
+public:
+    LogstalgiaBenchmark();
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,717 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compressedlog.h"
+#include "linescanner.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define COMPRESSED_LOG_INDEX_MAGIC "LSIDX001"
+
+static int compressed_log_seek(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64) offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET);
+#endif
+}
+
+CompressedLogCheckpoint::CompressedLogCheckpoint() {
+    input_offset  = 0;
+    output_offset = 0;
+    bits = 0;
+}
+
+// decompresses a file from the start or from a checkpoint
+
+class CompressedLogDecoder {
+protected:
+    FILE* file;
+
+    std::vector<unsigned char> input;
+    size_t input_length;
+    size_t input_pos;
+    uint64_t input_start;
+
+    uint64_t output_offset;
+    bool finished;
+
+    bool readInput();
+    void seekInput(uint64_t offset);
+public:
+    CompressedLogDecoder(const std::string& path);
+    virtual ~CompressedLogDecoder();
+
+    virtual bool restore(const CompressedLogCheckpoint& checkpoint) = 0;
+
+    // decompress up to size bytes, returning early where a checkpoint can be taken
+    virtual size_t decompress(char* data, size_t size) = 0;
+
+    // checkpoint at the current position if decompression can resume from it
+    virtual bool getCheckpoint(CompressedLogCheckpoint& checkpoint) = 0;
+
+    uint64_t getInputOffset() const;
+    uint64_t getOutputOffset() const;
+
+    bool isFinished() const;
+};
+
+CompressedLogDecoder::CompressedLogDecoder(const std::string& path) {
+    file = fopen(path.c_str(), "rb");
+
+    input.resize(COMPRESSED_LOG_CHUNK);
+    input_length  = 0;
+    input_pos     = 0;
+    input_start   = 0;
+    output_offset = 0;
+
+    finished = (file == 0);
+}
+
+CompressedLogDecoder::~CompressedLogDecoder() {
+    if(file != 0) fclose(file);
+}
+
+//read the next chunk of input once the current one is used up
+bool CompressedLogDecoder::readInput() {
+    if(input_pos < input_length) return true;
+    if(file == 0) return false;
+
+    input_start += input_length;
+    input_length = fread(&input[0], 1, input.size(), file);
+    input_pos    = 0;
+
+    return input_length > 0;
+}
+
+void CompressedLogDecoder::seekInput(uint64_t offset) {
+    if(file != 0 && compressed_log_seek(file, offset) != 0) {
+        finished = true;
+        return;
+    }
+
+    input_start  = offset;
+    input_length = 0;
+    input_pos    = 0;
+}
+
+//bytes of the file consumed by the decompressor
+uint64_t CompressedLogDecoder::getInputOffset() const {
+    return input_start + input_pos;
+}
+
+uint64_t CompressedLogDecoder::getOutputOffset() const {
+    return output_offset;
+}
+
+bool CompressedLogDecoder::isFinished() const {
+    return finished;
+}
+
+// gzip decoder. checkpoints are taken at deflate block boundaries and restored
+// by priming a raw inflate stream with the remaining bits and the last 32K of output
+
+class GZipLogDecoder : public CompressedLogDecoder {
+    z_stream stream;
+
+    bool raw;
+    bool at_block;
+    size_t trailer;
+public:
+    GZipLogDecoder(const std::string& path);
+    ~GZipLogDecoder();
+
+    bool restore(const CompressedLogCheckpoint& checkpoint);
+    size_t decompress(char* data, size_t size);
+    bool getCheckpoint(CompressedLogCheckpoint& checkpoint);
+};
+
+GZipLogDecoder::GZipLogDecoder(const std::string& path) : CompressedLogDecoder(path) {
+    memset(&stream, 0, sizeof(stream));
+
+    //gzip or zlib header
+    if(inflateInit2(&stream, 47) != Z_OK) finished = true;
+
+    raw      = false;
+    at_block = false;
+    trailer  = 0;
+}
+
+GZipLogDecoder::~GZipLogDecoder() {
+    inflateEnd(&stream);
+}
+
+bool GZipLogDecoder::restore(const CompressedLogCheckpoint& checkpoint) {
+
+    finished = (file == 0);
+    at_block = false;
+    trailer  = 0;
+    output_offset = checkpoint.output_offset;
+
+    if(checkpoint.input_offset == 0) {
+        raw = false;
+        seekInput(0);
+        return !finished && inflateReset2(&stream, 47) == Z_OK;
+    }
+
+    raw = true;
+
+    seekInput(checkpoint.input_offset - (checkpoint.bits ? 1 : 0));
+
+    if(finished || inflateReset2(&stream, -15) != Z_OK) return false;
+
+    if(checkpoint.bits) {
+        if(!readInput()) return false;
+
+        int value = input[input_pos++];
+        inflatePrime(&stream, checkpoint.bits, value >> (8 - checkpoint.bits));
+    }
+
+    return inflateSetDictionary(&stream, (const Bytef*) checkpoint.window.data(), checkpoint.window.size()) == Z_OK;
+}
+
+size_t GZipLogDecoder::decompress(char* data, size_t size) {
+
+    size_t written = 0;
+
+    at_block = false;
+
+    while(written < size && !finished) {
+
+        bool more_input = readInput();
+
+        //skip the trailer of a member read from a checkpoint
+        if(trailer > 0) {
+            if(!more_input) {
+                finished = true;
+                break;
+            }
+
+            size_t skip = std::min(trailer, input_length - input_pos);
+            input_pos += skip;
+            trailer   -= skip;
+            continue;
+        }
+
+        stream.next_in   = &input[0] + input_pos;
+        stream.avail_in  = input_length - input_pos;
+        stream.next_out  = (Bytef*) data + written;
+        stream.avail_out = size - written;
+
+        int ret = inflate(&stream, Z_BLOCK);
+
+        size_t produced = (size - written) - stream.avail_out;
+
+        input_pos     = stream.next_in - &input[0];
+        written       += produced;
+        output_offset += produced;
+
+        if(ret == Z_STREAM_END) {
+            //concatenated members each begin with a header
+            if(raw) trailer = 8;
+
+            raw = false;
+            inflateReset2(&stream, 47);
+            continue;
+        }
+
+        if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            debugLog("gzip decompression error: %s", stream.msg != 0 ? stream.msg : "unknown");
+            finished = true;
+            break;
+        }
+
+        if(!more_input && produced == 0) {
+            finished = true;
+            break;
+        }
+
+        //at the end of a block that is not the last
+        if((stream.data_type & 128) && !(stream.data_type & 64)) {
+            at_block = true;
+            break;
+        }
+    }
+
+    return written;
+}
+
+bool GZipLogDecoder::getCheckpoint(CompressedLogCheckpoint& checkpoint) {
+    if(!at_block || finished) return false;
+
+    unsigned char window[32768];
+    uInt window_length = 0;
+
+    if(inflateGetDictionary(&stream, window, &window_length) != Z_OK) return false;
+
+    checkpoint.input_offset  = getInputOffset();
+    checkpoint.output_offset = output_offset;
+    checkpoint.bits          = stream.data_type & 7;
+    checkpoint.window.assign((const char*) window, window_length);
+
+    return true;
+}
+
+#ifdef HAVE_ZSTD
+
+// zstd decoder. frames are decompressed independently so checkpoints are
+// taken between frames. a file of one frame can only resume from the start
+
+class ZstdLogDecoder : public CompressedLogDecoder {
+    ZSTD_DStream* stream;
+    bool at_frame;
+public:
+    ZstdLogDecoder(const std::string& path);
+    ~ZstdLogDecoder();
+
+    bool restore(const CompressedLogCheckpoint& checkpoint);
+    size_t decompress(char* data, size_t size);
+    bool getCheckpoint(CompressedLogCheckpoint& checkpoint);
+};
+
+ZstdLogDecoder::ZstdLogDecoder(const std::string& path) : CompressedLogDecoder(path) {
+    stream = ZSTD_createDStream();
+
+    if(stream == 0 || ZSTD_isError(ZSTD_initDStream(stream))) finished = true;
+
+    at_frame = false;
+}
+
+ZstdLogDecoder::~ZstdLogDecoder() {
+    if(stream != 0) ZSTD_freeDStream(stream);
+}
+
+bool ZstdLogDecoder::restore(const CompressedLogCheckpoint& checkpoint) {
+
+    finished = (file == 0 || stream == 0);
+    at_frame = false;
+    output_offset = checkpoint.output_offset;
+
+    seekInput(checkpoint.input_offset);
+
+    return !finished && !ZSTD_isError(ZSTD_initDStream(stream));
+}
+
+size_t ZstdLogDecoder::decompress(char* data, size_t size) {
+
+    size_t written = 0;
+
+    at_frame = false;
+
+    while(written < size && !finished) {
+
+        bool more_input = readInput();
+
+        ZSTD_inBuffer  in  = { &input[0], input_length, input_pos };
+        ZSTD_outBuffer out = { data, size, written };
+
+        size_t ret = ZSTD_decompressStream(stream, &out, &in);
+
+        size_t produced = out.pos - written;
+
+        input_pos     = in.pos;
+        written       = out.pos;
+        output_offset += produced;
+
+        if(ZSTD_isError(ret)) {
+            debugLog("zstd decompression error: %s", ZSTD_getErrorName(ret));
+            finished = true;
+            break;
+        }
+
+        if(!more_input && produced == 0) {
+            finished = true;
+            break;
+        }
+
+        //end of a frame
+        if(ret == 0) {
+            at_frame = true;
+            break;
+        }
+    }
+
+    return written;
+}
+
+bool ZstdLogDecoder::getCheckpoint(CompressedLogCheckpoint& checkpoint) {
+    if(!at_frame || finished) return false;
+
+    checkpoint.input_offset  = getInputOffset();
+    checkpoint.output_offset = output_offset;
+    checkpoint.bits = 0;
+    checkpoint.window.clear();
+
+    return true;
+}
+
+#endif
+
+//CompressedLog
+
+CompressedLog::CompressedLog(const std::string& path, CompressedLogFormat format, uint64_t file_size, time_t modified_time)
+    : path(path), format(format), file_size(file_size), modified_time(modified_time) {
+
+    index_path = path + ".lsidx";
+
+    buffer_pos      = 0;
+    peek_buffer_pos = 0;
+
+    decoder      = createDecoder();
+    peek_decoder = createDecoder();
+
+    //decompression can always start from the beginning
+    checkpoints.push_back(CompressedLogCheckpoint());
+
+    indexed = false;
+    running = true;
+
+    if(!loadIndex()) {
+        index_thread = std::thread(&CompressedLog::buildIndex, this);
+    }
+}
+
+CompressedLog::~CompressedLog() {
+    running = false;
+
+    if(index_thread.joinable()) index_thread.join();
+
+    delete decoder;
+    delete peek_decoder;
+}
+
+CompressedLog* CompressedLog::open(const std::string& path) {
+
+    struct stat file_stat;
+
+    if(stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) return 0;
+
+    FILE* file = fopen(path.c_str(), "rb");
+
+    if(file == 0) return 0;
+
+    unsigned char magic[4];
+    size_t magic_length = fread(magic, 1, 4, file);
+
+    fclose(file);
+
+    CompressedLogFormat format;
+
+    if(magic_length >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        format = COMPRESSED_LOG_GZIP;
+    } else if(magic_length == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        format = COMPRESSED_LOG_ZSTD;
+    } else {
+        return 0;
+    }
+
+#ifndef HAVE_ZSTD
+    if(format == COMPRESSED_LOG_ZSTD) {
+        debugLog("zstd compressed logs are not supported by this build");
+        throw SeekLogException(path);
+    }
+#endif
+
+    return new CompressedLog(path, format, file_stat.st_size, file_stat.st_mtime);
+}
+
+CompressedLogDecoder* CompressedLog::createDecoder() {
+#ifdef HAVE_ZSTD
+    if(format == COMPRESSED_LOG_ZSTD) return new ZstdLogDecoder(path);
+#endif
+    return new GZipLogDecoder(path);
+}
+
+bool CompressedLog::isIndexed() const {
+    return indexed;
+}
+
+size_t CompressedLog::getCheckpointCount() {
+    std::lock_guard<std::mutex> lock(checkpoints_mutex);
+
+    return checkpoints.size();
+}
+
+//nearest checkpoint at or before an offset of the compressed file
+void CompressedLog::getCheckpoint(uint64_t input_offset, CompressedLogCheckpoint& checkpoint) {
+
+    std::lock_guard<std::mutex> lock(checkpoints_mutex);
+
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), input_offset,
+        [](uint64_t offset, const CompressedLogCheckpoint& c) { return offset < c.input_offset; });
+
+    checkpoint = *(--it);
+}
+
+//position a decoder at the first complete line at or after a position in the compressed file
+void CompressedLog::seekDecoder(CompressedLogDecoder* decoder, std::string& buffer, size_t& buffer_pos, float percent) {
+
+    uint64_t target = (uint64_t) ((double) file_size * percent);
+
+    CompressedLogCheckpoint checkpoint;
+    getCheckpoint(target, checkpoint);
+
+    //carry on from the current position if it is closer than the checkpoint
+    uint64_t current = decoder->getInputOffset();
+
+    if(decoder->isFinished() || current > target || current < checkpoint.input_offset || target == 0) {
+        if(!decoder->restore(checkpoint)) debugLog("failed to restore checkpoint at %lu", (unsigned long) checkpoint.input_offset);
+    }
+
+    buffer.resize(COMPRESSED_LOG_CHUNK);
+
+    size_t length = 0;
+
+    while(!decoder->isFinished() && decoder->getInputOffset() < target) {
+        length = decoder->decompress(&buffer[0], buffer.size());
+    }
+
+    buffer.resize(length);
+    buffer_pos = 0;
+
+    if(target == 0) return;
+
+    //skip the remainder of a partial line
+    std::string partial_line;
+    readLine(decoder, buffer, buffer_pos, partial_line);
+}
+
+//read the next line, decompressing more of the file as needed
+bool CompressedLog::readLine(CompressedLogDecoder* decoder, std::string& buffer, size_t& buffer_pos, std::string& line) {
+
+    size_t scanned = 0;
+
+    while(true) {
+        size_t length = scanned + LineScanner::findLineEnd(buffer.data() + buffer_pos + scanned, buffer.size() - buffer_pos - scanned);
+
+        if(buffer_pos + length < buffer.size()) {
+            line.assign(buffer, buffer_pos, length);
+            buffer_pos += length + 1;
+            return true;
+        }
+
+        if(decoder->isFinished()) {
+            if(buffer_pos >= buffer.size()) return false;
+
+            line.assign(buffer, buffer_pos, std::string::npos);
+            buffer_pos = buffer.size();
+            return true;
+        }
+
+        //keep the partial line and decompress more after it
+        buffer.erase(0, buffer_pos);
+        buffer_pos = 0;
+        scanned    = buffer.size();
+
+        buffer.resize(scanned + COMPRESSED_LOG_CHUNK);
+
+        size_t decompressed = decoder->decompress(&buffer[scanned], COMPRESSED_LOG_CHUNK);
+
+        buffer.resize(scanned + decompressed);
+    }
+}
+
+float CompressedLog::getPercent() {
+    if(isFinished()) return 1.0f;
+
+    return (float) ((double) decoder->getInputOffset() / file_size);
+}
+
+void CompressedLog::seekTo(float percent) {
+    seekDecoder(decoder, buffer, buffer_pos, percent);
+}
+
+bool CompressedLog::getNextLineAt(std::string& line, float percent) {
+
+    seekDecoder(peek_decoder, peek_buffer, peek_buffer_pos, percent);
+
+    return readLine(peek_decoder, peek_buffer, peek_buffer_pos, line);
+}
+
+bool CompressedLog::getNextLine(std::string& line) {
+    return readLine(decoder, buffer, buffer_pos, line);
+}
+
+bool CompressedLog::isFinished() {
+    return decoder->isFinished() && buffer_pos >= buffer.size();
+}
+
+//index thread
+void CompressedLog::buildIndex() {
+
+    CompressedLogDecoder* index_decoder = createDecoder();
+
+    std::vector<char> output(COMPRESSED_LOG_CHUNK);
+
+    uint64_t last_output_offset = 0;
+
+    while(running && !index_decoder->isFinished()) {
+
+        index_decoder->decompress(&output[0], output.size());
+
+        if(index_decoder->getOutputOffset() - last_output_offset < COMPRESSED_LOG_SPAN) continue;
+
+        CompressedLogCheckpoint checkpoint;
+
+        if(!index_decoder->getCheckpoint(checkpoint)) continue;
+
+        last_output_offset = checkpoint.output_offset;
+
+        std::lock_guard<std::mutex> lock(checkpoints_mutex);
+        checkpoints.push_back(checkpoint);
+    }
+
+    uint64_t output_size = index_decoder->getOutputOffset();
+
+    delete index_decoder;
+
+    if(!running) return;
+
+    indexed = true;
+
+    debugLog("indexed %s (%lu bytes uncompressed)", path.c_str(), (unsigned long) output_size);
+
+    saveIndex();
+}
+
+//the index is only used if the file has the same size and modification time
+bool CompressedLog::loadIndex() {
+
+    FILE* file = fopen(index_path.c_str(), "rb");
+
+    if(file == 0) return false;
+
+    char magic[8];
+    uint64_t index_file_size = 0;
+    int64_t index_modified_time = 0;
+    uint32_t count = 0;
+
+    bool valid = fread(magic, 1, 8, file) == 8 && memcmp(magic, COMPRESSED_LOG_INDEX_MAGIC, 8) == 0
+        && fread(&index_file_size, sizeof(index_file_size), 1, file) == 1
+        && fread(&index_modified_time, sizeof(index_modified_time), 1, file) == 1
+        && fread(&count, sizeof(count), 1, file) == 1
+        && index_file_size == file_size && index_modified_time == (int64_t) modified_time
+        && count > 0;
+
+    std::deque<CompressedLogCheckpoint> index_checkpoints;
+
+    for(uint32_t i=0; valid && i<count; i++) {
+        CompressedLogCheckpoint checkpoint;
+
+        uint8_t bits = 0;
+        uint32_t window_length = 0;
+
+        valid = fread(&checkpoint.input_offset, sizeof(checkpoint.input_offset), 1, file) == 1
+            && fread(&checkpoint.output_offset, sizeof(checkpoint.output_offset), 1, file) == 1
+            && fread(&bits, sizeof(bits), 1, file) == 1
+            && fread(&window_length, sizeof(window_length), 1, file) == 1
+            && bits < 8 && window_length <= 32768
+            && checkpoint.input_offset <= file_size;
+
+        if(!valid) break;
+
+        checkpoint.bits = bits;
+        checkpoint.window.resize(window_length);
+
+        if(window_length > 0 && fread(&checkpoint.window[0], 1, window_length, file) != window_length) {
+            valid = false;
+            break;
+        }
+
+        //checkpoints must be in order, starting from the beginning
+        if(index_checkpoints.empty() ? checkpoint.input_offset != 0 : checkpoint.input_offset <= index_checkpoints.back().input_offset) {
+            valid = false;
+            break;
+        }
+
+        index_checkpoints.push_back(checkpoint);
+    }
+
+    fclose(file);
+
+    if(!valid) {
+        debugLog("ignoring out of date or invalid index %s", index_path.c_str());
+        return false;
+    }
+
+    checkpoints.swap(index_checkpoints);
+    indexed = true;
+
+    return true;
+}
+
+//write to a temporary file and then rename so a partial index is never read
+void CompressedLog::saveIndex() {
+
+    std::string temp_path = index_path + ".tmp";
+
+    FILE* file = fopen(temp_path.c_str(), "wb");
+
+    if(file == 0) {
+        debugLog("unable to write index %s", index_path.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(checkpoints_mutex);
+
+    uint64_t index_file_size = file_size;
+    int64_t index_modified_time = modified_time;
+    uint32_t count = checkpoints.size();
+
+    bool written = fwrite(COMPRESSED_LOG_INDEX_MAGIC, 1, 8, file) == 8
+        && fwrite(&index_file_size, sizeof(index_file_size), 1, file) == 1
+        && fwrite(&index_modified_time, sizeof(index_modified_time), 1, file) == 1
+        && fwrite(&count, sizeof(count), 1, file) == 1;
+
+    for(const CompressedLogCheckpoint& checkpoint : checkpoints) {
+        if(!written) break;
+
+        uint8_t bits = checkpoint.bits;
+        uint32_t window_length = checkpoint.window.size();
+
+        written = fwrite(&checkpoint.input_offset, sizeof(checkpoint.input_offset), 1, file) == 1
+            && fwrite(&checkpoint.output_offset, sizeof(checkpoint.output_offset), 1, file) == 1
+            && fwrite(&bits, sizeof(bits), 1, file) == 1
+            && fwrite(&window_length, sizeof(window_length), 1, file) == 1
+            && (window_length == 0 || fwrite(checkpoint.window.data(), 1, window_length, file) == window_length);
+    }
+
+    if(fclose(file) != 0) written = false;
+
+#ifdef _WIN32
+    //rename does not replace an existing file
+    if(written) remove(index_path.c_str());
+#endif
+
+    if(!written || rename(temp_path.c_str(), index_path.c_str()) != 0) {
+        debugLog("unable to write index %s", index_path.c_str());
+        remove(temp_path.c_str());
+    }
+}
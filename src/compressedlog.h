@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPRESSED_LOG_H
+#define COMPRESSED_LOG_H
+
+#include "seekablelog.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <time.h>
+
+//uncompressed bytes between seek index checkpoints
+#define COMPRESSED_LOG_SPAN 2097152
+
+//bytes read or decompressed at a time
+#define COMPRESSED_LOG_CHUNK 65536
+
+enum CompressedLogFormat { COMPRESSED_LOG_GZIP, COMPRESSED_LOG_ZSTD };
+
+// position in a compressed file decompression can resume from
+
+struct CompressedLogCheckpoint {
+    uint64_t input_offset;
+    uint64_t output_offset;
+
+    //gzip only: unused bits of the byte before the input offset and
+    //the preceding 32K of output the next block may refer back to
+    int bits;
+    std::string window;
+
+    CompressedLogCheckpoint();
+};
+
+class CompressedLogDecoder;
+
+// gzip or zstd compressed log file.
+// a thread decompresses the whole file once, recording checkpoints every few
+// megabytes of output, so seeking only needs to decompress from the nearest one.
+// the checkpoints are saved to a sidecar index file next to the log when possible
+
+class CompressedLog : public SeekableLog {
+    std::string path;
+    std::string index_path;
+
+    CompressedLogFormat format;
+    uint64_t file_size;
+    time_t modified_time;
+
+    CompressedLogDecoder* decoder;
+    std::string buffer;
+    size_t buffer_pos;
+
+    CompressedLogDecoder* peek_decoder;
+    std::string peek_buffer;
+    size_t peek_buffer_pos;
+
+    std::deque<CompressedLogCheckpoint> checkpoints;
+    std::mutex checkpoints_mutex;
+
+    std::atomic<bool> indexed;
+    std::atomic<bool> running;
+    std::thread index_thread;
+
+    CompressedLog(const std::string& path, CompressedLogFormat format, uint64_t file_size, time_t modified_time);
+
+    CompressedLogDecoder* createDecoder();
+
+    void getCheckpoint(uint64_t input_offset, CompressedLogCheckpoint& checkpoint);
+
+    void seekDecoder(CompressedLogDecoder* decoder, std::string& buffer, size_t& buffer_pos, float percent);
+    bool readLine(CompressedLogDecoder* decoder, std::string& buffer, size_t& buffer_pos, std::string& line);
+
+    void buildIndex();
+    bool loadIndex();
+    void saveIndex();
+public:
+    ~CompressedLog();
+
+    // returns 0 if the file is not compressed.
+    // throws SeekLogException if the compression format is not supported
+    static CompressedLog* open(const std::string& path);
+
+    bool isIndexed() const;
+    size_t getCheckpointCount();
+
+    float getPercent();
+    void seekTo(float percent);
+
+    bool getNextLineAt(std::string& line, float percent);
+    bool getNextLine(std::string& line);
+    bool isFinished();
+};
+
+#endif
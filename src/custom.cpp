@@ -1,6 +1,5 @@
 #include "custom.h"
 
-#include "core/regex.h"
 #include "settings.h"
 
 //timestamp
@@ -15,48 +14,86 @@
 //virtual_host
 //pid
 
-Regex custom_entry("^([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)\\|([^|]*)(?:\\|([^|]*))?(?:\\|#?([^|]*))?(?:\\|([^|]*))?(?:\\|([^|]*))?(?:\\|([^|]*))?(?:\\|([^|]*))?$");
+#define CUSTOM_MAX_FIELDS 11
 
 CustomAccessLog::CustomAccessLog() {
 }
 
+AccessLog* CustomAccessLog::clone() const {
+    return new CustomAccessLog();
+}
+
+const char* CustomAccessLog::getFormatName() const {
+    return "custom";
+}
+
 bool CustomAccessLog::parseLine(std::string& line, LogEntry& entry) {
 
-    std::vector<std::string> matches;
+    boost::string_view line_view(line);
+
+    boost::string_view fields[CUSTOM_MAX_FIELDS];
+    size_t field_count = 0;
+
+    size_t field_start = 0;
+
+    while(true) {
+        if(field_count == CUSTOM_MAX_FIELDS) return false;
+
+        size_t field_end = line_view.find('|', field_start);
+
+        if(field_end == boost::string_view::npos) {
+            fields[field_count++] = line_view.substr(field_start);
+            break;
+        }
+
+        fields[field_count++] = line_view.substr(field_start, field_end - field_start);
+
+        field_start = field_end + 1;
+    }
+
+    if(field_count < 5) return false;
 
-    if(!custom_entry.match(line, &matches)) return false;
+    entry.reset();
 
-    entry.timestamp = atol(matches[0].c_str());
-    entry.hostname  = matches[1];
-    entry.path      = matches[2];
-    entry.response_code = matches[3];
-    entry.response_size = atol(matches[4].c_str());
+    // NOTE: fields are followed by a separator or the null terminator of the line
+
+    entry.timestamp = atol(fields[0].data());
+    entry.hostname  = intern_table.intern(fields[1]);
+    entry.path      = intern_table.intern(fields[2]);
+    entry.response_size = atol(fields[4].data());
+
+    //the other fields are views of one stored copy of the line
+    boost::string_view stored_line = entry.storeLine(line);
 
     if(settings.display_log_entry) {
-        entry.log_entry = line;
+        entry.log_entry = stored_line;
     }
 
+    entry.response_code = entry.storeField(fields[3]);
+
     //optional fields
 
     //success 1 or 0
-    if(matches.size() > 5) {
-        std::string success = matches[5];
+    if(field_count > 5) {
+        boost::string_view success = fields[5];
 
         if(success.empty() || (success.size()==1 && success[0] == ' ')) {
             entry.setSuccess();
         } else {
-            entry.successful = atoi(success.c_str())==1 ? true : false;
+            entry.successful = atoi(success.data())==1 ? true : false;
         }
     } else entry.setSuccess();
 
     //response colour
-    if(matches.size()>6) {
+    if(field_count > 6) {
+
+        boost::string_view colour = fields[6];
 
-        std::string colour = matches[6];
+        if(!colour.empty() && colour[0] == '#') colour.remove_prefix(1);
 
         int r, g, b;
         if(colour.size()>0 &&
-           sscanf(colour.c_str(), "%02x%02x%02x", &r, &g, &b) == 3) {
+           sscanf(colour.data(), "%02x%02x%02x", &r, &g, &b) == 3) {
             entry.response_colour = vec3( r, g, b );
             entry.response_colour /= 255.0f;
         } else {
@@ -65,23 +102,23 @@ bool CustomAccessLog::parseLine(std::string& line, LogEntry& entry) {
     } else entry.setResponseColour();
 
     //referrer
-    if(matches.size()>7) {
-        entry.referrer   = matches[7];
+    if(field_count > 7) {
+        entry.referrer   = entry.storeField(fields[7]);
     }
 
     //user agent
-    if(matches.size()>8) {
-        entry.user_agent = matches[8];
+    if(field_count > 8) {
+        entry.user_agent = entry.storeField(fields[8]);
     }
 
     //vhost
-    if(matches.size()>9) {
-        entry.vhost = matches[9];
+    if(field_count > 9) {
+        entry.vhost = intern_table.intern(fields[9]);
     }
 
     //pid or some other identifier
-    if(matches.size()>10) {
-        entry.pid = matches[10];
+    if(field_count > 10) {
+        entry.pid = intern_table.intern(fields[10]);
     }
 
     return entry.validate();
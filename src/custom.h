@@ -24,6 +24,8 @@ class CustomAccessLog : public AccessLog {
 
 public:
     CustomAccessLog();
+    AccessLog* clone() const;
+    const char* getFormatName() const;
     bool parseLine(std::string& line, LogEntry& entry);
 };
 
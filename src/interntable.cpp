@@ -0,0 +1,179 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "interntable.h"
+
+InternTable intern_table;
+
+//InternTableEntry
+
+InternTableEntry::InternTableEntry(const boost::string_view& str, int id)
+    : str(str.data(), str.size()), id(id), refs(0) {
+}
+
+//InternedString
+
+const std::string intern_empty_string;
+
+InternedString::InternedString() : entry(0) {
+}
+
+InternedString::InternedString(InternTableEntry* entry) : entry(entry) {
+}
+
+InternedString::InternedString(const InternedString& other) : entry(other.entry) {
+    if(entry != 0) {
+        entry->refs++;
+        intern_table.references++;
+    }
+}
+
+InternedString::~InternedString() {
+    if(entry != 0) intern_table.release(entry);
+}
+
+InternedString& InternedString::operator=(const InternedString& other) {
+
+    if(entry == other.entry) return *this;
+
+    if(other.entry != 0) {
+        other.entry->refs++;
+        intern_table.references++;
+    }
+
+    if(entry != 0) intern_table.release(entry);
+
+    entry = other.entry;
+
+    return *this;
+}
+
+int InternedString::getId() const {
+    return entry != 0 ? entry->id : 0;
+}
+
+const std::string& InternedString::str() const {
+    return entry != 0 ? entry->str : intern_empty_string;
+}
+
+bool InternedString::empty() const {
+    return entry == 0;
+}
+
+bool InternedString::operator==(const InternedString& other) const {
+    return entry == other.entry;
+}
+
+bool InternedString::operator!=(const InternedString& other) const {
+    return entry != other.entry;
+}
+
+//InternTableHash
+
+size_t InternedStringHash::operator()(const InternedString& str) const {
+    return std::hash<int>()(str.getId());
+}
+
+size_t InternTableHash::operator()(const boost::string_view& str) const {
+
+    //FNV-1a
+    size_t hash = 2166136261u;
+
+    for(char c : str) {
+        hash = (hash ^ (unsigned char) c) * 16777619u;
+    }
+
+    return hash;
+}
+
+//InternTable
+
+InternTable::InternTable() : next_id(1), references(0) {
+}
+
+InternTable::~InternTable() {
+    for(auto& it : entries) {
+        delete it.second;
+    }
+    entries.clear();
+}
+
+InternedString InternTable::intern(const boost::string_view& str) {
+
+    //the empty string is not stored and has id 0
+    if(str.empty()) return InternedString();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    InternTableEntry* entry = 0;
+
+    auto it = entries.find(str);
+
+    if(it != entries.end()) {
+        entry = it->second;
+    } else {
+        int id;
+
+        if(!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+        } else {
+            id = next_id++;
+        }
+
+        entry = new InternTableEntry(str, id);
+
+        //key is a view of the string owned by the entry
+        entries[boost::string_view(entry->str)] = entry;
+    }
+
+    entry->refs++;
+    references++;
+
+    return InternedString(entry);
+}
+
+void InternTable::release(InternTableEntry* entry) {
+
+    references--;
+
+    //only need to lock the table if this may be the last reference
+    int refs = entry->refs;
+
+    while(refs > 1) {
+        if(entry->refs.compare_exchange_weak(refs, refs - 1)) return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(--entry->refs > 0) return;
+
+    entries.erase(boost::string_view(entry->str));
+    free_ids.push_back(entry->id);
+
+    delete entry;
+}
+
+size_t InternTable::getUniqueCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t InternTable::getTotalCount() const {
+    return references;
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INTERN_TABLE_H
+#define INTERN_TABLE_H
+
+#include <boost/utility/string_view.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class InternTable;
+
+class InternTableEntry {
+public:
+    InternTableEntry(const boost::string_view& str, int id);
+
+    std::string str;
+    int id;
+    std::atomic<int> refs;
+};
+
+// reference counted handle to a string in the intern table.
+// equal strings share the same entry so can be compared by id
+
+class InternedString {
+    InternTableEntry* entry;
+
+    friend class InternTable;
+    InternedString(InternTableEntry* entry);
+public:
+    InternedString();
+    InternedString(const InternedString& other);
+    ~InternedString();
+
+    InternedString& operator=(const InternedString& other);
+
+    int getId() const;
+    const std::string& str() const;
+
+    bool empty() const;
+
+    bool operator==(const InternedString& other) const;
+    bool operator!=(const InternedString& other) const;
+};
+
+// hash of an interned string by its id
+class InternedStringHash {
+public:
+    size_t operator()(const InternedString& str) const;
+};
+
+class InternTableHash {
+public:
+    size_t operator()(const boost::string_view& str) const;
+};
+
+class InternTable {
+    std::mutex mutex;
+
+    std::unordered_map<boost::string_view, InternTableEntry*, InternTableHash> entries;
+    std::vector<int> free_ids;
+    int next_id;
+
+    std::atomic<size_t> references;
+
+    friend class InternedString;
+    void release(InternTableEntry* entry);
+public:
+    InternTable();
+    ~InternTable();
+
+    InternedString intern(const boost::string_view& str);
+
+    size_t getUniqueCount();
+    size_t getTotalCount() const;
+};
+
+extern InternTable intern_table;
+
+#endif
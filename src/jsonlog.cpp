@@ -0,0 +1,464 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "jsonlog.h"
+#include "settings.h"
+
+#include <cstring>
+
+const char* ls_json_field_names[] = {
+    "timestamp", "hostname", "vhost", "path", "method", "protocol", "request",
+    "response_code", "response_size", "referrer", "user_agent", "pid"
+};
+
+// keys used by common nginx and envoy JSON log configurations
+const char* ls_json_default_keys[][7] = {
+    { "time", "timestamp", "@timestamp", "time_iso8601", "start_time", "msec", 0 },
+    { "remote_addr", "client_ip", "remote_ip", "downstream_remote_address", "hostname", 0 },
+    { "host", "server_name", "authority", "vhost", 0 },
+    { "path", "uri", "request_uri", "url", 0 },
+    { "method", "request_method", 0 },
+    { "protocol", "server_protocol", 0 },
+    { "request", 0 },
+    { "status", "response_code", "code", 0 },
+    { "body_bytes_sent", "bytes_sent", "response_size", "size", 0 },
+    { "http_referer", "referer", "referrer", 0 },
+    { "http_user_agent", "user_agent", 0 },
+    { "pid", 0 }
+};
+
+//JSONLogKey
+
+JSONLogKey::JSONLogKey(const std::string& key, int field) : key(key), field(field) {
+}
+
+//JSONLog
+
+JSONLog::JSONLog() {
+
+    //keys set for a field replace its default keys
+    bool configured[JSON_FIELD_COUNT] = { false };
+
+    for(auto& mapping : settings.json_fields) {
+        int field = getFieldByName(mapping.first);
+
+        if(field == -1) continue;
+
+        addKey(mapping.second, field);
+        configured[field] = true;
+    }
+
+    for(int field=0; field<JSON_FIELD_COUNT; field++) {
+        if(configured[field]) continue;
+
+        for(int i=0; ls_json_default_keys[field][i] != 0; i++) {
+            addKey(ls_json_default_keys[field][i], field);
+        }
+    }
+}
+
+AccessLog* JSONLog::clone() const {
+    return new JSONLog();
+}
+
+const char* JSONLog::getFormatName() const {
+    return "json";
+}
+
+int JSONLog::getFieldByName(const std::string& name) {
+
+    for(int field=0; field<JSON_FIELD_COUNT; field++) {
+        if(name == ls_json_field_names[field]) return field;
+    }
+
+    return -1;
+}
+
+void JSONLog::addKey(const std::string& key, int field) {
+    keys.push_back(JSONLogKey(key, field));
+}
+
+int JSONLog::getField(const boost::string_view& key) const {
+
+    for(const JSONLogKey& k : keys) {
+        if(k.key.size() == key.size() && memcmp(k.key.data(), key.data(), key.size()) == 0) {
+            return k.field;
+        }
+    }
+
+    return -1;
+}
+
+static inline const char* ls_json_skip_space(const char* p) {
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+//scan a string starting at the opening quote, returning the raw contents
+//and the position after the closing quote, or 0 if the string is not terminated
+static const char* ls_json_scan_string(const char* p, boost::string_view& str, bool& escaped) {
+
+    const char* start = ++p;
+
+    escaped = false;
+
+    while(*p != '"') {
+        if(*p == '\0') return 0;
+
+        if(*p == '\\') {
+            escaped = true;
+            if(*++p == '\0') return 0;
+        }
+
+        p++;
+    }
+
+    str = boost::string_view(start, p - start);
+
+    return p + 1;
+}
+
+static int ls_json_hex_digit(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+//decode escape sequences. characters outside of ASCII are replaced with '?'
+//as other high bit characters in the log are
+static void ls_json_unescape(const boost::string_view& str, std::string& output) {
+
+    output.clear();
+
+    for(size_t i=0; i<str.size(); i++) {
+
+        char c = str[i];
+
+        if(c != '\\' || i+1 >= str.size()) {
+            output += c;
+            continue;
+        }
+
+        c = str[++i];
+
+        switch(c) {
+            case 'b': output += '\b'; break;
+            case 'f': output += '\f'; break;
+            case 'n': output += '\n'; break;
+            case 'r': output += '\r'; break;
+            case 't': output += '\t'; break;
+            case 'u': {
+                int code = 0;
+                int digits = 0;
+
+                while(digits < 4 && i+1 < str.size()) {
+                    int value = ls_json_hex_digit(str[i+1]);
+                    if(value == -1) break;
+
+                    code = code * 16 + value;
+                    digits++;
+                    i++;
+                }
+
+                output += (code > 0 && code < 0x80) ? (char) code : '?';
+                break;
+            }
+            default:
+                output += c;
+                break;
+        }
+    }
+}
+
+//skip an object or array, including any nested within it
+static const char* ls_json_skip_nested(const char* p) {
+
+    int depth = 0;
+
+    boost::string_view str;
+    bool escaped;
+
+    while(*p != '\0') {
+        if(*p == '"') {
+            if(!(p = ls_json_scan_string(p, str, escaped))) return 0;
+            continue;
+        }
+
+        if(*p == '{' || *p == '[') {
+            depth++;
+        } else if(*p == '}' || *p == ']') {
+            if(--depth == 0) return p + 1;
+        }
+
+        p++;
+    }
+
+    return 0;
+}
+
+//read exactly count digits
+static const char* ls_json_read_digits(const char* p, int count, int& value) {
+
+    value = 0;
+
+    for(int i=0; i<count; i++) {
+        if(p[i] < '0' || p[i] > '9') return 0;
+        value = value * 10 + (p[i] - '0');
+    }
+
+    return p + count;
+}
+
+//parse a unix timestamp (optionally with a fraction, in seconds or milliseconds)
+//or an ISO 8601 date (YYYY-MM-DDThh:mm:ss[.fraction][Z|+hh:mm]). dates without a
+//utc offset are assumed to be in UTC. returns 0 if not recognized
+time_t JSONLog::parseTimestamp(const boost::string_view& value) {
+
+    if(value.empty()) return 0;
+
+    const char* p   = value.data();
+    const char* end = p + value.size();
+
+    const char* digits_end = p;
+    while(digits_end < end && *digits_end >= '0' && *digits_end <= '9') digits_end++;
+
+    //unix timestamp
+    if(digits_end != p && (digits_end == end || *digits_end == '.')) {
+
+        int digit_count = digits_end - p;
+
+        if(digit_count > 13) return 0;
+
+        time_t timestamp = 0;
+        for(; p < digits_end; p++) timestamp = timestamp * 10 + (*p - '0');
+
+        if(digit_count > 11) timestamp /= 1000;
+
+        return timestamp;
+    }
+
+    if(value.size() < 19) return 0;
+
+    int year, month, day, hour, minute, second;
+
+    if(   !(p = ls_json_read_digits(p, 4, year))   || *p++ != '-'
+       || !(p = ls_json_read_digits(p, 2, month))  || *p++ != '-'
+       || !(p = ls_json_read_digits(p, 2, day))    || (*p != 'T' && *p != ' ')
+       || !(p = ls_json_read_digits(p+1, 2, hour)) || *p++ != ':'
+       || !(p = ls_json_read_digits(p, 2, minute)) || *p++ != ':'
+       || !(p = ls_json_read_digits(p, 2, second))) {
+        return 0;
+    }
+
+    if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) return 0;
+
+    //ignore fractions of a second
+    if(p < end && *p == '.') {
+        p++;
+        while(p < end && *p >= '0' && *p <= '9') p++;
+    }
+
+    int tz_offset = 0;
+
+    if(p < end && (*p == '+' || *p == '-')) {
+
+        int sign = *p++ == '-' ? -1 : 1;
+
+        int tz_hour, tz_min = 0;
+
+        if(end - p < 2 || !(p = ls_json_read_digits(p, 2, tz_hour))) return 0;
+
+        if(p < end && *p == ':') p++;
+
+        if(end - p >= 2 && !(p = ls_json_read_digits(p, 2, tz_min))) return 0;
+
+        tz_offset = sign * (tz_hour * 3600 + tz_min * 60);
+
+    } else if(p < end && *p == 'Z') {
+        p++;
+    }
+
+    if(p != end) return 0;
+
+    return toTimestamp(year, month-1, day, hour, minute, second, tz_offset);
+}
+
+bool JSONLog::parseLine(std::string& line, LogEntry& entry) {
+
+    boost::string_view values[JSON_FIELD_COUNT];
+    bool found[JSON_FIELD_COUNT] = { false };
+
+    const char* p = ls_json_skip_space(line.c_str());
+
+    if(*p++ != '{') return false;
+
+    p = ls_json_skip_space(p);
+
+    if(*p == '}') return false;
+
+    boost::string_view key;
+    boost::string_view value;
+    bool escaped;
+
+    while(true) {
+
+        if(*p != '"') return false;
+
+        if(!(p = ls_json_scan_string(p, key, escaped))) return false;
+
+        if(escaped) {
+            ls_json_unescape(key, unescaped_key);
+            key = unescaped_key;
+        }
+
+        p = ls_json_skip_space(p);
+
+        if(*p++ != ':') return false;
+
+        p = ls_json_skip_space(p);
+
+        int field = getField(key);
+
+        if(field != -1 && found[field]) field = -1;
+
+        if(*p == '"') {
+
+            if(!(p = ls_json_scan_string(p, value, escaped))) return false;
+
+            if(field != -1) {
+                if(escaped) {
+                    ls_json_unescape(value, unescaped[field]);
+                    value = unescaped[field];
+                }
+
+                values[field] = value;
+                found[field]  = true;
+            }
+
+        } else if(*p == '{' || *p == '[') {
+
+            if(!(p = ls_json_skip_nested(p))) return false;
+
+        } else {
+
+            //number, true, false or null
+            const char* literal_start = p;
+
+            while(*p != '\0' && *p != ',' && *p != '}' && *p != ' ' && *p != '\t') p++;
+
+            if(p == literal_start) return false;
+
+            value = boost::string_view(literal_start, p - literal_start);
+
+            if(field != -1 && value != "null") {
+                values[field] = value;
+                found[field]  = true;
+            }
+        }
+
+        p = ls_json_skip_space(p);
+
+        if(*p == ',') {
+            p = ls_json_skip_space(p + 1);
+            continue;
+        }
+
+        if(*p == '}') break;
+
+        return false;
+    }
+
+    //split request line into method, path and protocol if they were not given separately
+    if(found[JSON_REQUEST]) {
+
+        boost::string_view request = values[JSON_REQUEST];
+        boost::string_view request_fields[3];
+
+        for(int i=0; i<3 && !request.empty(); i++) {
+            size_t sep = request.find(' ');
+
+            request_fields[i] = request.substr(0, sep);
+
+            if(sep == boost::string_view::npos) break;
+
+            request = request.substr(sep + 1);
+
+            while(!request.empty() && request[0] == ' ') request.remove_prefix(1);
+        }
+
+        int request_field_ids[3] = { JSON_METHOD, JSON_PATH, JSON_PROTOCOL };
+
+        for(int i=0; i<3; i++) {
+            int field = request_field_ids[i];
+
+            if(!found[field] && !request_fields[i].empty()) {
+                values[field] = request_fields[i];
+                found[field]  = true;
+            }
+        }
+    }
+
+    time_t timestamp = parseTimestamp(values[JSON_TIMESTAMP]);
+
+    if(timestamp == 0) return false;
+
+    //remove the port from addresses like 10.0.0.1:8080 or [::1]:8080
+    boost::string_view hostname = values[JSON_HOSTNAME];
+
+    if(!hostname.empty() && hostname[0] == '[') {
+        size_t bracket = hostname.find(']');
+
+        if(bracket != boost::string_view::npos) hostname = hostname.substr(1, bracket - 1);
+
+    } else {
+        size_t colon = hostname.find(':');
+
+        if(colon != boost::string_view::npos && hostname.find(':', colon + 1) == boost::string_view::npos) {
+            hostname = hostname.substr(0, colon);
+        }
+    }
+
+    entry.reset();
+
+    entry.timestamp = timestamp;
+    entry.hostname  = intern_table.intern(hostname);
+    entry.vhost     = intern_table.intern(values[JSON_VHOST]);
+    entry.path      = intern_table.intern(values[JSON_PATH]);
+    entry.pid       = intern_table.intern(values[JSON_PID]);
+
+    //values are views of one stored copy of the line, only unescaped values are copied
+    boost::string_view stored_line = entry.storeLine(line);
+
+    if(settings.display_log_entry) {
+        entry.log_entry = stored_line;
+    }
+
+    if(found[JSON_METHOD])        entry.method        = entry.storeField(values[JSON_METHOD]);
+    if(found[JSON_PROTOCOL])      entry.protocol      = entry.storeField(values[JSON_PROTOCOL]);
+    if(found[JSON_RESPONSE_CODE]) entry.response_code = entry.storeField(values[JSON_RESPONSE_CODE]);
+    if(found[JSON_REFERRER])      entry.referrer      = entry.storeField(values[JSON_REFERRER]);
+    if(found[JSON_USER_AGENT])    entry.user_agent    = entry.storeField(values[JSON_USER_AGENT]);
+
+    // NOTE: values are followed by a non digit character or the null terminator of the line
+    if(found[JSON_RESPONSE_SIZE]) entry.response_size = atol(values[JSON_RESPONSE_SIZE].data());
+
+    entry.setSuccess();
+    entry.setResponseColour();
+
+    return entry.validate();
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef JSON_ACCESS_LOG
+#define JSON_ACCESS_LOG
+
+#include "logentry.h"
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+#include <vector>
+
+enum {
+    JSON_TIMESTAMP,
+    JSON_HOSTNAME,
+    JSON_VHOST,
+    JSON_PATH,
+    JSON_METHOD,
+    JSON_PROTOCOL,
+    JSON_REQUEST,
+    JSON_RESPONSE_CODE,
+    JSON_RESPONSE_SIZE,
+    JSON_REFERRER,
+    JSON_USER_AGENT,
+    JSON_PID,
+    JSON_FIELD_COUNT
+};
+
+class JSONLogKey {
+public:
+    JSONLogKey(const std::string& key, int field);
+
+    std::string key;
+    int field;
+};
+
+// one JSON object per line, with keys mapped to log entry fields.
+// values of keys not mapped to a field are skipped without being decoded
+
+class JSONLog : public AccessLog {
+
+protected:
+    std::vector<JSONLogKey> keys;
+
+    // values containing escape sequences are decoded here
+    std::string unescaped[JSON_FIELD_COUNT];
+    std::string unescaped_key;
+
+    void addKey(const std::string& key, int field);
+    int getField(const boost::string_view& key) const;
+
+    time_t parseTimestamp(const boost::string_view& value);
+public:
+    JSONLog();
+    AccessLog* clone() const;
+    const char* getFormatName() const;
+    bool parseLine(std::string& line, LogEntry& entry);
+
+    // field with the given name, or -1 if it cannot be mapped to a key
+    static int getFieldByName(const std::string& name);
+};
+
+#endif
@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "linebuffer.h"
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#define LINE_BUFFER_MAX_FREE_BLOCKS 64
+
+std::mutex line_buffer_pool_mutex;
+std::vector<LineBufferBlock*> line_buffer_free_blocks;
+
+// block currently being filled by this thread
+
+class LineBufferCursor {
+public:
+    LineBufferBlock* block;
+
+    LineBufferCursor() : block(0) {}
+
+    ~LineBufferCursor() {
+        if(block != 0) block->unref();
+    }
+};
+
+thread_local LineBufferCursor line_buffer_cursor;
+
+//LineBufferBlock
+
+LineBufferBlock::LineBufferBlock(size_t capacity) : refs(0), used(0), capacity(capacity) {
+    data = new char[capacity];
+}
+
+LineBufferBlock::~LineBufferBlock() {
+    delete[] data;
+}
+
+LineBufferBlock* LineBufferBlock::allocate(size_t size) {
+
+    //oversized blocks are not pooled
+    if(size > LINE_BUFFER_BLOCK_SIZE) {
+        return new LineBufferBlock(size);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(line_buffer_pool_mutex);
+
+        if(!line_buffer_free_blocks.empty()) {
+            LineBufferBlock* block = line_buffer_free_blocks.back();
+            line_buffer_free_blocks.pop_back();
+            return block;
+        }
+    }
+
+    return new LineBufferBlock(LINE_BUFFER_BLOCK_SIZE);
+}
+
+void LineBufferBlock::ref() {
+    refs++;
+}
+
+void LineBufferBlock::unref() {
+    if(--refs > 0) return;
+
+    if(capacity == LINE_BUFFER_BLOCK_SIZE) {
+        std::lock_guard<std::mutex> lock(line_buffer_pool_mutex);
+
+        if(line_buffer_free_blocks.size() < LINE_BUFFER_MAX_FREE_BLOCKS) {
+            used = 0;
+            line_buffer_free_blocks.push_back(this);
+            return;
+        }
+    }
+
+    delete this;
+}
+
+//LineBuffer
+
+LineBuffer::LineBuffer() : block(0), offset(0), length(0) {
+}
+
+LineBuffer::LineBuffer(const LineBuffer& other) : block(other.block), offset(other.offset), length(other.length) {
+    if(block != 0) block->ref();
+}
+
+LineBuffer::~LineBuffer() {
+    clear();
+}
+
+LineBuffer& LineBuffer::operator=(const LineBuffer& other) {
+
+    if(other.block != 0) other.block->ref();
+
+    clear();
+
+    block  = other.block;
+    offset = other.offset;
+    length = other.length;
+
+    return *this;
+}
+
+const char* LineBuffer::data() const {
+    return block != 0 ? block->data + offset : 0;
+}
+
+size_t LineBuffer::size() const {
+    return length;
+}
+
+void LineBuffer::clear() {
+    if(block != 0) block->unref();
+
+    block  = 0;
+    offset = 0;
+    length = 0;
+}
+
+size_t LineBuffer::append(const char* str, size_t str_length) {
+
+    LineBufferBlock* current = line_buffer_cursor.block;
+
+    size_t str_offset = length;
+
+    //include null terminator
+    size_t append_length = str_length + 1;
+
+    //extend in place if the region is at the end of the block this thread is filling
+    if(block != 0 && block == current && offset + length == current->used && current->used + append_length <= current->capacity) {
+        memcpy(current->data + current->used, str, str_length);
+        current->data[current->used + str_length] = '\0';
+
+        current->used += append_length;
+        length        += append_length;
+
+        return str_offset;
+    }
+
+    size_t required = length + append_length;
+
+    if(current == 0 || current->used + required > current->capacity) {
+        if(current != 0) current->unref();
+
+        current = line_buffer_cursor.block = LineBufferBlock::allocate(required);
+        current->ref();
+    }
+
+    //copy existing region followed by the appended string
+    char* dest = current->data + current->used;
+
+    if(length > 0) memcpy(dest, block->data + offset, length);
+    memcpy(dest + length, str, str_length);
+    dest[length + str_length] = '\0';
+
+    current->ref();
+
+    if(block != 0) block->unref();
+
+    block  = current;
+    offset = current->used;
+    length = required;
+
+    current->used += required;
+
+    return str_offset;
+}
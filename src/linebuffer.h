@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINE_BUFFER_H
+#define LINE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+#define LINE_BUFFER_BLOCK_SIZE 65536
+
+// block of memory holding the text of many log lines.
+// blocks are reference counted and returned to a pool when no longer used
+
+class LineBufferBlock {
+public:
+    LineBufferBlock(size_t capacity);
+    ~LineBufferBlock();
+
+    std::atomic<int> refs;
+
+    size_t used;
+    size_t capacity;
+    char* data;
+
+    static LineBufferBlock* allocate(size_t size);
+
+    void ref();
+    void unref();
+};
+
+// region of a block owned by a log entry
+
+class LineBuffer {
+    LineBufferBlock* block;
+    size_t offset;
+    size_t length;
+public:
+    LineBuffer();
+    LineBuffer(const LineBuffer& other);
+    ~LineBuffer();
+
+    LineBuffer& operator=(const LineBuffer& other);
+
+    const char* data() const;
+    size_t size() const;
+
+    void clear();
+
+    // append a null terminated copy of a string to the end of the region, moving the region
+    // to another block if there is not room. returns the offset of the string within the region
+    size_t append(const char* str, size_t str_length);
+};
+
+#endif
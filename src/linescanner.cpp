@@ -0,0 +1,231 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "linescanner.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LS_LINE_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define LS_LINE_SCANNER_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline bool ls_is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int ls_highest_bit(unsigned int mask) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(mask);
+#else
+    int bit = 0;
+    while(mask >>= 1) bit++;
+    return bit;
+#endif
+}
+
+static inline int ls_lowest_bit(unsigned int mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while(!(mask & 1)) { mask >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+size_t LineScanner::filterLineScalar(char* data, size_t length) {
+
+    size_t end = 0;
+
+    for(size_t i=0; i<length; i++) {
+        unsigned char c = data[i];
+
+        if(c & 0x80) {
+            data[i] = '?';
+            end = i + 1;
+        } else if(!ls_is_space(c)) {
+            end = i + 1;
+        }
+    }
+
+    return end;
+}
+
+size_t LineScanner::findLineEndScalar(const char* data, size_t length) {
+
+    for(size_t i=0; i<length; i++) {
+        if(data[i] == '\n') return i;
+    }
+
+    return length;
+}
+
+#ifdef LS_LINE_SCANNER_SSE2
+
+static size_t ls_filter_line_sse2(char* data, size_t length) {
+
+    const __m128i question = _mm_set1_epi8('?');
+    const __m128i space    = _mm_set1_epi8(' ');
+    const __m128i tab      = _mm_set1_epi8('\t');
+    const __m128i four     = _mm_set1_epi8(4);
+    const __m128i zero     = _mm_setzero_si128();
+
+    size_t end = 0;
+    size_t i   = 0;
+
+    for(; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (data + i));
+
+        //bytes with the high bit set are negative
+        __m128i high = _mm_cmplt_epi8(v, zero);
+
+        if(_mm_movemask_epi8(high)) {
+            v = _mm_or_si128(_mm_and_si128(high, question), _mm_andnot_si128(high, v));
+            _mm_storeu_si128((__m128i*) (data + i), v);
+        }
+
+        //whitespace is ' ' or '\t' to '\r'
+        __m128i control    = _mm_sub_epi8(v, tab);
+        __m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(_mm_min_epu8(control, four), control));
+
+        unsigned int content = ~_mm_movemask_epi8(whitespace) & 0xFFFF;
+
+        if(content) end = i + ls_highest_bit(content) + 1;
+    }
+
+    size_t tail_end = LineScanner::filterLineScalar(data + i, length - i);
+
+    return tail_end > 0 ? i + tail_end : end;
+}
+
+static size_t ls_find_line_end_sse2(const char* data, size_t length) {
+
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for(; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (data + i));
+
+        unsigned int found = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+
+        if(found) return i + ls_lowest_bit(found);
+    }
+
+    return i + LineScanner::findLineEndScalar(data + i, length - i);
+}
+
+#endif
+
+#ifdef LS_LINE_SCANNER_AVX2
+
+__attribute__((target("avx2")))
+static size_t ls_filter_line_avx2(char* data, size_t length) {
+
+    const __m256i question = _mm256_set1_epi8('?');
+    const __m256i space    = _mm256_set1_epi8(' ');
+    const __m256i tab      = _mm256_set1_epi8('\t');
+    const __m256i four     = _mm256_set1_epi8(4);
+    const __m256i zero     = _mm256_setzero_si256();
+
+    size_t end = 0;
+    size_t i   = 0;
+
+    for(; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (data + i));
+
+        __m256i high = _mm256_cmpgt_epi8(zero, v);
+
+        if(_mm256_movemask_epi8(high)) {
+            v = _mm256_blendv_epi8(v, question, high);
+            _mm256_storeu_si256((__m256i*) (data + i), v);
+        }
+
+        __m256i control    = _mm256_sub_epi8(v, tab);
+        __m256i whitespace = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(_mm256_min_epu8(control, four), control));
+
+        unsigned int content = ~((unsigned int) _mm256_movemask_epi8(whitespace));
+
+        if(content) end = i + ls_highest_bit(content) + 1;
+    }
+
+    size_t tail_end = LineScanner::filterLineScalar(data + i, length - i);
+
+    return tail_end > 0 ? i + tail_end : end;
+}
+
+__attribute__((target("avx2")))
+static size_t ls_find_line_end_avx2(const char* data, size_t length) {
+
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+
+    for(; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (data + i));
+
+        unsigned int found = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+
+        if(found) return i + ls_lowest_bit(found);
+    }
+
+    return i + LineScanner::findLineEndScalar(data + i, length - i);
+}
+
+static bool ls_has_avx2() {
+    static bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif
+
+size_t LineScanner::filterLine(char* data, size_t length) {
+#ifdef LS_LINE_SCANNER_AVX2
+    if(ls_has_avx2()) return ls_filter_line_avx2(data, length);
+#endif
+#ifdef LS_LINE_SCANNER_SSE2
+    return ls_filter_line_sse2(data, length);
+#else
+    return filterLineScalar(data, length);
+#endif
+}
+
+size_t LineScanner::findLineEnd(const char* data, size_t length) {
+#ifdef LS_LINE_SCANNER_AVX2
+    if(ls_has_avx2()) return ls_find_line_end_avx2(data, length);
+#endif
+#ifdef LS_LINE_SCANNER_SSE2
+    return ls_find_line_end_sse2(data, length);
+#else
+    return findLineEndScalar(data, length);
+#endif
+}
+
+const char* LineScanner::getInstructionSet() {
+#ifdef LS_LINE_SCANNER_AVX2
+    if(ls_has_avx2()) return "avx2";
+#endif
+#ifdef LS_LINE_SCANNER_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINE_SCANNER_H
+#define LINE_SCANNER_H
+
+#include <cstddef>
+
+// scans log text a vector register at a time where supported
+// (AVX2 or SSE2 on x86, chosen at run time) with a scalar fallback
+
+class LineScanner {
+public:
+    // replace characters with the high bit set with '?' and return
+    // the length of the line without trailing whitespace
+    static size_t filterLine(char* data, size_t length);
+
+    // offset of the first newline, or length if there is none
+    static size_t findLineEnd(const char* data, size_t length);
+
+    static size_t filterLineScalar(char* data, size_t length);
+    static size_t findLineEndScalar(const char* data, size_t length);
+
+    // name of the instruction set used
+    static const char* getInstructionSet();
+};
+
+#endif
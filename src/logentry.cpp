@@ -25,6 +25,46 @@
 //AccessLog
 
 AccessLog::AccessLog() {
+    cached_year  = 0;
+    cached_month = -1;
+    cached_day   = 0;
+    cached_day_start = 0;
+}
+
+//days since the epoch of the first day of a month (range 0-11) of the gregorian calendar
+static time_t logentry_days_from_civil(int year, int month) {
+
+    //count years from march so the leap day is the last day of the year
+    time_t y = (month < 2) ? (time_t) year - 1 : (time_t) year;
+    int m = (month < 2) ? month + 10 : month - 2;
+
+    time_t era = (y >= 0 ? y : y - 399) / 400;
+    time_t yoe = y - era * 400;
+    time_t doy = (153 * m + 2) / 5;
+    time_t doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+//convert a utc offset date to a unix timestamp.
+//equivalent to mktime() in the UTC timezone, the start of the last day seen is cached
+//as most lines in a log share the same date
+time_t AccessLog::toTimestamp(int year, int month, int day, int hour, int minute, int second, int tz_offset) {
+
+    if(day != cached_day || month != cached_month || year != cached_year) {
+        cached_day_start = (logentry_days_from_civil(year, month) + day - 1) * 86400;
+
+        cached_year  = year;
+        cached_month = month;
+        cached_day   = day;
+    }
+
+    time_t timestamp = cached_day_start + (time_t) hour * 3600 + (time_t) minute * 60 + second;
+
+    //apply utc offset
+    timestamp -= tz_offset;
+
+    return timestamp;
 }
 
 //LogEntry
@@ -33,13 +73,138 @@ std::vector<std::string> LogEntry::fields;
 std::vector<std::string> LogEntry::default_fields;
 std::map<std::string, std::string> LogEntry::field_titles;
 
+boost::string_view LogEntry::* LogEntry::string_fields[] = {
+    &LogEntry::log_entry,
+    &LogEntry::method,
+    &LogEntry::protocol,
+    &LogEntry::response_code,
+    &LogEntry::referrer,
+    &LogEntry::user_agent,
+    0
+};
+
 LogEntry::LogEntry() {
     timestamp = 0;
     response_size = 0;
     successful = false;
     response_colour = vec3(1.0, 0.0, 0.0);
+    group = -1;
+    group_version = 0;
+    line_source = 0;
+    line_length = 0;
+    line_offset = 0;
+}
+
+void LogEntry::reset() {
+
+    for(int i=0; string_fields[i] != 0; i++) {
+        this->*string_fields[i] = boost::string_view();
+    }
+
+    hostname = InternedString();
+    vhost    = InternedString();
+    path     = InternedString();
+    pid      = InternedString();
+
+    display_path = InternedString();
+
+    timestamp = 0;
+    response_size = 0;
+    successful = false;
+    response_colour = vec3(1.0, 0.0, 0.0);
+    group = -1;
+    group_version = 0;
+
+    line_source = 0;
+    line_length = 0;
+    line_offset = 0;
+
+    buffer.clear();
 }
 
+//store a null terminated copy of a string in the line buffer
+boost::string_view LogEntry::store(const boost::string_view& str) {
+
+    const char* old_data = buffer.data();
+    size_t old_size      = buffer.size();
+
+    size_t offset = buffer.append(str.data(), str.size());
+
+    const char* data = buffer.data();
+
+    //update views of the previous location if the buffer moved
+    if(data != old_data && old_size > 0) {
+        for(int i=0; string_fields[i] != 0; i++) {
+            boost::string_view& field = this->*string_fields[i];
+
+            if(!field.empty() && field.data() >= old_data && field.data() < old_data + old_size) {
+                field = boost::string_view(data + (field.data() - old_data), field.size());
+            }
+        }
+    }
+
+    return boost::string_view(data + offset, str.size());
+}
+
+//store a copy of the line the entry is being parsed from
+boost::string_view LogEntry::storeLine(const boost::string_view& line) {
+
+    boost::string_view stored = store(line);
+
+    line_source = line.data();
+    line_length = line.size();
+    line_offset = stored.data() - buffer.data();
+
+    return stored;
+}
+
+//view of a field within the stored line, or a copy of a field not
+//taken from the line (eg one that had to be unescaped)
+boost::string_view LogEntry::storeField(const boost::string_view& str) {
+
+    if(str.empty()) return boost::string_view();
+
+    if(line_source != 0 && str.data() >= line_source && str.data() + str.size() <= line_source + line_length) {
+        return boost::string_view(buffer.data() + line_offset + (str.data() - line_source), str.size());
+    }
+
+    return store(str);
+}
+
+//format timestamp as local time.
+//the formatted date and time up to the minute is reused while timestamps fall within the same minute
+void LogEntry::formatTimestamp(time_t timestamp, std::string& value) {
+
+    static time_t minute_start = 0;
+    static std::string minute_str;
+
+    if(minute_str.empty() || timestamp < minute_start || timestamp >= minute_start + 60) {
+
+        struct tm* timeinfo = localtime ( &timestamp );
+        char timestamp_buff[256];
+
+        //leap second
+        if(timeinfo->tm_sec > 59) {
+            strftime(timestamp_buff, 256, "%Y-%m-%d %H:%M:%S", timeinfo);
+            value = std::string(timestamp_buff);
+            return;
+        }
+
+        strftime(timestamp_buff, 256, "%Y-%m-%d %H:%M:", timeinfo);
+
+        minute_start = timestamp - timeinfo->tm_sec;
+        minute_str   = std::string(timestamp_buff);
+    }
+
+    int second = timestamp - minute_start;
+
+    value = minute_str;
+    value += (char) ('0' + second / 10);
+    value += (char) ('0' + second % 10);
+}
+
+Regex logentry_url_prefix("^https?://[^/]+(.+)$");
+
 Regex logentry_ipv6("(?i)^[a-f0-9:]+$");
 
 Regex logentry_hostname_parts("([^.]+)(?:\\.([^.]+))?(?:\\.([^.]+))?(?:\\.([^.]+))?(?:\\.([^.]+))?(?:\\.([^.]+))?(?:\\.([^.]+))?(?:\\.([^.]+))?$");
@@ -115,14 +280,14 @@ std::string LogEntry::maskHostname(const std::string& hostname) {
 
 void LogEntry::setSuccess() {
 
-    int code = atoi(response_code.c_str());
+    int code = atoi(response_code.to_string().c_str());
 
     successful = (code<400) ? true : false;
 }
 
 void LogEntry::setResponseColour() {
 
-    int code = atoi(response_code.c_str());
+    int code = atoi(response_code.to_string().c_str());
 
     //set response colour
     if(code<200) {
@@ -203,32 +368,32 @@ const std::string& LogEntry::getFieldTitle(const std::string& field) {
 bool LogEntry::getValue(const std::string& field, std::string& value) const {
 
     if(field == "pid") {
-        value = pid;
+        value = pid.str();
         return true;
     }
 
     if(field == "path") {
-        value = path;
+        value = path.str();
         return true;
     }
 
     if(field == "method") {
-        value = method;
+        value = method.to_string();
         return true;
     }
 
     if(field == "protocol") {
-        value = protocol;
+        value = protocol.to_string();
         return true;
     }
 
     if(field == "hostname") {
-        value = hostname;
+        value = hostname.str();
         return true;
     }
 
     if(field == "vhost") {
-        value = vhost;
+        value = vhost.str();
         return true;
     }
 
@@ -238,30 +403,27 @@ bool LogEntry::getValue(const std::string& field, std::string& value) const {
     }
 
     if(field == "response_code") {
-        value = response_code;
+        value = response_code.to_string();
         return true;
     }
 
     if(field == "referrer") {
-        value = referrer;
+        value = referrer.to_string();
         return true;
     }
 
     if(field == "user_agent") {
-        value = user_agent;
+        value = user_agent.to_string();
         return true;
     }
 
     if(field == "timestamp") {
-        struct tm* timeinfo = localtime ( &timestamp );
-        char timestamp_buff[256];
-        strftime(timestamp_buff, 256, "%Y-%m-%d %H:%M:%S", timeinfo);
-        value = std::string(timestamp_buff);
+        formatTimestamp(timestamp, value);
         return true;
     }
 
     if(field == "log_entry") {
-        value = log_entry;
+        value = log_entry.to_string();
         return true;
     }
 
@@ -270,17 +432,27 @@ bool LogEntry::getValue(const std::string& field, std::string& value) const {
 }
 
 bool LogEntry::validate() {
-    if(pid == "-") pid = "";
-    if(referrer == "-") referrer = "";
+    if(pid.str() == "-") pid = InternedString();
+    if(referrer == "-") referrer = boost::string_view();
 
     if(hostname.empty()) return false;
 
     if(settings.mask_hostnames) {
-        hostname = maskHostname(hostname);
+        hostname = intern_table.intern(maskHostname(hostname.str()));
     }
 
     if(path.empty()) return false;
     if(timestamp == 0) return false;
 
+    display_path = path;
+
+    if(settings.hide_url_prefix) {
+        std::vector<std::string> matches;
+
+        if(logentry_url_prefix.match(path.str(), &matches)) {
+            display_path = intern_table.intern(matches[0]);
+        }
+    }
+
     return true;
 }
@@ -20,6 +20,11 @@
 
 #include "core/vectors.h"
 
+#include "linebuffer.h"
+#include "interntable.h"
+
+#include <boost/utility/string_view.hpp>
+
 #include <string>
 #include <vector>
 #include <map>
@@ -32,39 +37,71 @@ private:
     static std::vector<std::string> default_fields;
     static std::map<std::string, std::string> field_titles;
 
+    static boost::string_view LogEntry::* string_fields[];
+
+    LineBuffer buffer;
+
+    // line the entry is being parsed from and the offset of its copy in the buffer
+    const char* line_source;
+    size_t line_length;
+    size_t line_offset;
+
     std::string maskHostname(const std::string& hostname);
+
+    static void formatTimestamp(time_t timestamp, std::string& value);
 public:
     LogEntry();
     bool validate();
 
+    void reset();
+
+    boost::string_view store(const boost::string_view& str);
+
+    // store one copy of the line being parsed. fields within the line
+    // are then stored as views of the copy instead of copies of their own
+    boost::string_view storeLine(const boost::string_view& line);
+    boost::string_view storeField(const boost::string_view& str);
+
     void setSuccess();
     void setResponseColour();
 
     bool getValue(const std::string& field, std::string& value) const;
 
-    std::string log_entry;
+    // frequently repeated fields are interned, the others
+    // are views of the text stored in the line buffer
+
+    boost::string_view log_entry;
 
     time_t timestamp;
 
-    std::string hostname;
-    std::string vhost;
+    InternedString hostname;
+    InternedString vhost;
 
-    std::string path;
+    InternedString path;
 
-    std::string pid;
-    std::string method;
-    std::string protocol;
+    // path as summarized, without the scheme and hostname of
+    // an absolute url if hide_url_prefix is set
+    InternedString display_path;
 
-    std::string response_code;
+    InternedString pid;
+    boost::string_view method;
+    boost::string_view protocol;
+
+    boost::string_view response_code;
     long response_size;
 
-    std::string referrer;
-    std::string user_agent;
+    boost::string_view referrer;
+    boost::string_view user_agent;
 
     vec3 response_colour;
 
     bool successful;
 
+    // index of the group summarizer of the entry (-1 if none), found
+    // once and kept while group_version matches the version of the groups
+    int group;
+    int group_version;
+
     static const std::vector<std::string>& getFields();
     static const std::vector<std::string>& getDefaultFields();
     static const std::string& getFieldTitle(const std::string& field);
@@ -72,11 +109,23 @@ public:
 
 class AccessLog {
 
+protected:
+    int cached_year;
+    int cached_month;
+    int cached_day;
+    time_t cached_day_start;
+
+    time_t toTimestamp(int year, int month, int day, int hour, int minute, int second, int tz_offset);
 public:
     AccessLog();
     virtual ~AccessLog() {};
     virtual bool parseLine(std::string& line, LogEntry& entry) = 0;
 
+    // new parser of the same format, for use by another thread
+    virtual AccessLog* clone() const = 0;
+
+    virtual const char* getFormatName() const = 0;
+
 };
 
 #endif
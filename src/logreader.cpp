@@ -0,0 +1,482 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logreader.h"
+#include "accesslogregistry.h"
+#include "linescanner.h"
+#include "settings.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+
+// formats previously detected for each log file, freed at exit
+
+std::mutex log_reader_formats_mutex;
+std::map<std::string, std::unique_ptr<AccessLog> > log_reader_formats;
+
+//LogReaderBatch
+
+LogReaderBatch::LogReaderBatch() : position(0), percent(0.0f), parsed(false) {
+    lines.reserve(LOG_READER_BATCH_SIZE);
+}
+
+LogReaderBatch::~LogReaderBatch() {
+    for(LogEntry* le : entries) {
+        if(le != 0) delete le;
+    }
+}
+
+//LogReader
+
+LogReader::LogReader(BaseLog* log, const std::string& path, int parser_count)
+    : log(log), path(path), format(0), line_count(0), failed_line_count(0), running(true), finished(false), idle(false),
+      percent(0.0f), batches(LOG_READER_MAX_BATCHES), peek_request(-1.0f), peek_percent(-1.0f), peek_found(false) {
+
+    seeklog = dynamic_cast<SeekableLog*>(log);
+
+    if(!settings.log_format.empty()) {
+        format = AccessLogRegistry::create(settings.log_format);
+
+    } else if(!path.empty()) {
+        std::lock_guard<std::mutex> lock(log_reader_formats_mutex);
+
+        auto it = log_reader_formats.find(path);
+
+        if(it != log_reader_formats.end()) {
+            format = it->second->clone();
+        }
+    }
+
+    if(parser_count <= 0) parser_count = getDefaultParserCount();
+
+    for(int i=0;i<parser_count;i++) {
+        parser_threads.push_back(std::thread(&LogReader::parseBatches, this));
+    }
+
+    reader_thread = std::thread(&LogReader::readLines, this);
+
+    if(seeklog != 0) {
+        peek_thread = std::thread(&LogReader::peekLines, this);
+    }
+}
+
+LogReader::~LogReader() {
+
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        running = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(peek_mutex);
+    }
+
+    work_cond.notify_all();
+    space_cond.notify_all();
+    peek_cond.notify_all();
+
+    reader_thread.join();
+
+    if(peek_thread.joinable()) peek_thread.join();
+
+    for(std::thread& parser_thread : parser_threads) {
+        parser_thread.join();
+    }
+
+    //discard lines read ahead of the main thread
+    LogReaderBatch* batch;
+    while(batches.front(batch)) {
+        batches.pop();
+        delete batch;
+    }
+
+    AccessLog* accesslog = format.load();
+    if(accesslog != 0) delete accesslog;
+}
+
+int LogReader::getDefaultParserCount() {
+    //leave a core each for the main and reader threads
+    int cores = std::thread::hardware_concurrency();
+
+    return std::max(1, std::min(cores - 2, LOG_READER_MAX_PARSERS));
+}
+
+//replace high bit characters and trim trailing whitespace in a single pass
+void LogReader::filterLine(std::string& line) {
+
+    if(line.empty()) return;
+
+    size_t length = LineScanner::filterLine(&line[0], line.size());
+
+    if(length != line.size()) line.resize(length);
+}
+
+AccessLog* LogReader::createAccessLog() {
+    AccessLog* accesslog = format.load();
+
+    return accesslog != 0 ? accesslog->clone() : 0;
+}
+
+//try each registered format on a sample of lines from the start of the log
+//and return the one that parses the most, or 0 if no lines could be parsed
+AccessLog* LogReader::detectFormat(std::vector<LogReaderBatch*>& sample) {
+
+    std::vector<AccessLog*> formats = AccessLogRegistry::createAll();
+
+    AccessLog* best_format = 0;
+    int best_count  = 0;
+    int sample_size = 0;
+
+    LogEntry entry;
+
+    for(LogReaderBatch* batch : sample) {
+        for(std::string& linestr : batch->lines) {
+            filterLine(linestr);
+            sample_size++;
+        }
+    }
+
+    for(AccessLog* accesslog : formats) {
+
+        int parsed_count = 0;
+
+        for(LogReaderBatch* batch : sample) {
+            for(std::string& linestr : batch->lines) {
+                if(accesslog->parseLine(linestr, entry)) parsed_count++;
+            }
+        }
+
+        //ties go to the format tried first
+        if(parsed_count > best_count) {
+            best_format = accesslog;
+            best_count  = parsed_count;
+        }
+    }
+
+    for(AccessLog* accesslog : formats) {
+        if(accesslog != best_format) delete accesslog;
+    }
+
+    if(best_format != 0) {
+        debugLog("detected %s log format (%d of %d sample lines parsed)", best_format->getFormatName(), best_count, sample_size);
+    }
+
+    return best_format;
+}
+
+//parse each line of the batch. if the format is not known the lines are skipped
+void LogReader::parseBatch(LogReaderBatch* batch, AccessLog* accesslog) {
+
+    size_t batch_lines = batch->lines.size();
+
+    batch->entries.resize(batch_lines, 0);
+
+    int failed_count = 0;
+
+    //entries are parsed in place and only replaced once kept
+    LogEntry* le = 0;
+
+    for(size_t i=0;i<batch_lines;i++) {
+
+        std::string& linestr = batch->lines[i];
+
+        filterLine(linestr);
+
+        if(le == 0) le = new LogEntry();
+
+        if(accesslog != 0 && accesslog->parseLine(linestr, *le)) {
+            batch->entries[i] = le;
+            le = 0;
+        } else {
+            failed_count++;
+        }
+    }
+
+    if(le != 0) delete le;
+
+    line_count        += batch_lines;
+    failed_line_count += failed_count;
+
+    batch->parsed.store(true, std::memory_order_release);
+}
+
+//add batch to the queue for the main thread, waiting for space if required.
+//batches are parsed by the parser threads if the format is known
+void LogReader::queueBatch(LogReaderBatch* batch) {
+
+    while(!batches.push(batch)) {
+
+        if(!running) {
+            delete batch;
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(space_mutex);
+        space_cond.wait_for(lock, std::chrono::milliseconds(10));
+    }
+
+    if(format.load() == 0) {
+        parseBatch(batch, 0);
+        ready_cond.notify_all();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        work.push_back(batch);
+    }
+
+    work_cond.notify_one();
+}
+
+//reader thread
+void LogReader::readLines() {
+
+    std::string linestr;
+
+    //lines read before the format is known
+    std::vector<LogReaderBatch*> sample;
+    size_t sample_size = 0;
+
+    while(running) {
+
+        LogReaderBatch* batch = new LogReaderBatch();
+
+        bool more_lines = true;
+
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+
+            while(batch->lines.size() < LOG_READER_BATCH_SIZE && (more_lines = log->getNextLine(linestr))) {
+                batch->lines.push_back(std::string());
+                batch->lines.back().swap(linestr);
+            }
+
+            if(seeklog != 0) batch->percent = seeklog->getPercent();
+        }
+
+        if(!batch->lines.empty()) {
+
+            idle = false;
+
+            if(format.load() == 0) {
+                sample.push_back(batch);
+                sample_size += batch->lines.size();
+            } else {
+                queueBatch(batch);
+            }
+
+        } else {
+            delete batch;
+        }
+
+        //decide the format once there are enough lines, or no more are available yet
+        if(!sample.empty() && (sample_size >= LOG_READER_SAMPLE_LINES || !more_lines)) {
+
+            AccessLog* accesslog = detectFormat(sample);
+
+            if(accesslog != 0) {
+                format = accesslog;
+
+                if(!path.empty()) {
+                    std::lock_guard<std::mutex> lock(log_reader_formats_mutex);
+
+                    log_reader_formats[path].reset(accesslog->clone());
+                }
+            }
+
+            for(LogReaderBatch* sample_batch : sample) {
+                queueBatch(sample_batch);
+            }
+
+            sample.clear();
+            sample_size = 0;
+        }
+
+        if(!more_lines) {
+
+            //the end of a file is final, a stream may receive more lines later
+            if(seeklog != 0) {
+                finished = true;
+                ready_cond.notify_all();
+                break;
+            }
+
+            idle = true;
+            ready_cond.notify_all();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    for(LogReaderBatch* sample_batch : sample) {
+        delete sample_batch;
+    }
+}
+
+//parser thread
+void LogReader::parseBatches() {
+
+    AccessLog* accesslog = 0;
+
+    while(true) {
+
+        LogReaderBatch* batch = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(work_mutex);
+
+            while(running && work.empty()) {
+                work_cond.wait(lock);
+            }
+
+            if(!running) break;
+
+            batch = work.front();
+            work.pop_front();
+        }
+
+        //batches are only queued for parsing once the format is known
+        if(accesslog == 0) accesslog = createAccessLog();
+
+        parseBatch(batch, accesslog);
+
+        ready_cond.notify_all();
+    }
+
+    if(accesslog != 0) delete accesslog;
+}
+
+LogEntry* LogReader::getNextEntry(bool wait) {
+
+    LogReaderBatch* batch;
+
+    while(true) {
+
+        //check before looking at the queue so the last batch is not missed
+        bool caught_up = finished || idle;
+
+        if(batches.front(batch)) {
+
+            if(batch->parsed.load(std::memory_order_acquire)) {
+
+                percent = batch->percent;
+
+                while(batch->position < batch->entries.size()) {
+
+                    LogEntry* le = batch->entries[batch->position];
+                    batch->entries[batch->position++] = 0;
+
+                    if(le != 0) return le;
+                }
+
+                batches.pop();
+                delete batch;
+
+                space_cond.notify_one();
+                continue;
+            }
+
+        } else if(caught_up) {
+            return 0;
+        }
+
+        if(!wait) return 0;
+
+        std::unique_lock<std::mutex> lock(ready_mutex);
+        ready_cond.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+//peek thread
+void LogReader::peekLines() {
+
+    std::unique_lock<std::mutex> lock(peek_mutex);
+
+    while(running) {
+
+        if(peek_percent == peek_request) {
+            peek_cond.wait(lock);
+            continue;
+        }
+
+        float line_percent = peek_request;
+
+        lock.unlock();
+
+        //only a log peeking through the reader's own stream has to wait for the reader thread
+        std::string line;
+        bool found;
+
+        if(seeklog->peekSharesReader()) {
+            std::lock_guard<std::mutex> log_lock(log_mutex);
+            found = seeklog->getNextLineAt(line, line_percent);
+        } else {
+            found = seeklog->getNextLineAt(line, line_percent);
+        }
+
+        lock.lock();
+
+        peek_line.swap(line);
+        peek_found   = found;
+        peek_percent = line_percent;
+    }
+}
+
+bool LogReader::getNextLineAt(std::string& line, float line_percent) {
+    if(seeklog == 0) return false;
+
+    std::lock_guard<std::mutex> lock(peek_mutex);
+
+    if(line_percent != peek_request) {
+        peek_request = line_percent;
+        peek_cond.notify_one();
+    }
+
+    if(!peek_found) return false;
+
+    line = peek_line;
+
+    return true;
+}
+
+bool LogReader::isPeeking() {
+    std::lock_guard<std::mutex> lock(peek_mutex);
+
+    return peek_percent != peek_request;
+}
+
+int LogReader::getLineCount() const {
+    return line_count;
+}
+
+int LogReader::getFailedLineCount() const {
+    return failed_line_count;
+}
+
+//position in the log of the entries returned so far
+float LogReader::getPercent() const {
+    return percent;
+}
+
+bool LogReader::isFinished() const {
+    return finished && batches.empty();
+}
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#include "logentry.h"
+#include "seekablelog.h"
+#include "ringqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LOG_READER_BATCH_SIZE   256
+#define LOG_READER_MAX_BATCHES  128
+#define LOG_READER_MAX_PARSERS  4
+#define LOG_READER_SAMPLE_LINES 100
+
+// consecutive lines read from the log, parsed together by one parser thread
+
+class LogReaderBatch {
+public:
+    LogReaderBatch();
+    ~LogReaderBatch();
+
+    std::vector<std::string> lines;
+    std::vector<LogEntry*> entries;
+
+    size_t position;
+    float percent;
+
+    std::atomic<bool> parsed;
+};
+
+// reads the log on a separate thread and parses it with a pool of parser threads.
+// batches are handed back to the main thread in the order they were read
+
+class LogReader {
+    BaseLog* log;
+    SeekableLog* seeklog;
+
+    std::string path;
+
+    std::atomic<AccessLog*> format;
+
+    std::atomic<int> line_count;
+    std::atomic<int> failed_line_count;
+
+    std::atomic<bool> running;
+    std::atomic<bool> finished;
+    std::atomic<bool> idle;
+
+    float percent;
+
+    std::mutex log_mutex;
+
+    RingQueue<LogReaderBatch*> batches;
+
+    std::mutex work_mutex;
+    std::condition_variable work_cond;
+    std::deque<LogReaderBatch*> work;
+
+    std::mutex ready_mutex;
+    std::condition_variable ready_cond;
+
+    std::mutex space_mutex;
+    std::condition_variable space_cond;
+
+    std::thread reader_thread;
+    std::vector<std::thread> parser_threads;
+
+    // lines peeked at on the slider are read on a thread of their own so the
+    // main thread doesn't wait for the reader thread or for decompression.
+    // the latest request replaces any not yet started
+    std::mutex peek_mutex;
+    std::condition_variable peek_cond;
+    std::thread peek_thread;
+
+    float peek_request;
+    float peek_percent;
+    bool peek_found;
+    std::string peek_line;
+
+    void readLines();
+    void parseBatches();
+    void peekLines();
+
+    void queueBatch(LogReaderBatch* batch);
+
+    AccessLog* detectFormat(std::vector<LogReaderBatch*>& sample);
+
+    void parseBatch(LogReaderBatch* batch, AccessLog* accesslog);
+public:
+    LogReader(BaseLog* log, const std::string& path, int parser_count = 0);
+    ~LogReader();
+
+    static void filterLine(std::string& line);
+
+    static int getDefaultParserCount();
+
+    // new parser for the detected log format, or 0 if not yet known
+    AccessLog* createAccessLog();
+
+    int getLineCount() const;
+    int getFailedLineCount() const;
+
+    // next parsed entry in log order, or 0 if none is available.
+    // if wait is true blocks until the parser threads catch up with the reader
+    LogEntry* getNextEntry(bool wait);
+
+    // requests the line at a position of a seekable log and returns the line
+    // of the last request to be read, false if there is none
+    bool getNextLineAt(std::string& line, float line_percent);
+
+    // true until the line of the last request has been read
+    bool isPeeking();
+
+    float getPercent() const;
+
+    bool isFinished() const;
+};
+
+#endif
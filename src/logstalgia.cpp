@@ -20,8 +20,6 @@
 
 #include "logstalgia.h"
 #include "settings.h"
-#include "ncsa.h"
-#include "custom.h"
 #include "configwatcher.h"
 
 #include "core/png_writer.h"
@@ -73,10 +71,14 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
     message_timer = 0.0f;
 
     ipSummarizer  = 0;
+    group_version = 0;
+
+    request_window = 0;
 
     mintime       = settings.sync ? time(0) : settings.start_time;
     seeklog       = 0;
     streamlog     = 0;
+    logreader     = 0;
 
     if(logfile.empty()) {
         throw SDLAppException("no file supplied");
@@ -87,7 +89,7 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
 
     } else {
         try {
-            seeklog = new SeekLog(logfile);
+            seeklog = SeekableLog::open(logfile);
 
         } catch(SeekLogException& exception) {
             throw SDLAppException("unable to read log file");
@@ -105,6 +107,9 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
     toggle_delay = 0.0f;
     mousehide_timeout = 0.0f;
 
+    peek_position = 0.0f;
+    peek_pending  = false;
+
     runtime = 0.0;
     frameExporter = 0;
     framecount = 0;
@@ -130,10 +135,13 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
     detect_changes = settings.detect_changes;
     config_watcher = 0;
 
+    summarizer_pool = new SummarizerPool();
+
     init_tz();
 }
 
 Logstalgia::~Logstalgia() {
+    if(logreader!=0) delete logreader;
     if(accesslog!=0) delete accesslog;
 
     for(auto& it: paddles) {
@@ -145,10 +153,6 @@ Logstalgia::~Logstalgia() {
     if(streamlog!=0) delete streamlog;
     if(config_watcher!=0) delete config_watcher;
 
-    for(auto& it : summarizer_types) {
-        if(it.second != 0) delete it.second;
-    }
-
     if(ipSummarizer!=0) delete ipSummarizer;
 
     for(Summarizer* s : summarizers) {
@@ -156,8 +160,10 @@ Logstalgia::~Logstalgia() {
     }
 
     summarizers.clear();
-    summarizer_types.clear();
 
+    if(request_window!=0) delete request_window;
+
+    delete summarizer_pool;
 }
 
 void Logstalgia::togglePause() {
@@ -310,18 +316,20 @@ void Logstalgia::initPaddles() {
 
     if(settings.paddle_mode <= PADDLE_SINGLE) {
         vec2 paddle_pos = vec2(paddle_x - 20, rand() % display.height);
-        Paddle* paddle = new Paddle(paddle_pos, paddle_colour, "", fontSmall);
-        paddles[""] = paddle;
+        Paddle* paddle = new Paddle(paddle_pos, paddle_colour, InternedString(), fontSmall);
+        paddles[InternedString()] = paddle;
     }
 }
 
 void Logstalgia::initRequestBalls() {
 
-    for(RequestBall* r: balls) {
-        removeBall(r);
+    while(!balls.empty()) {
+        removeBall(balls.size()-1);
     }
 
-    balls.clear();
+    removed_strings.removeStrings();
+
+    if(request_window != 0) request_window->clear();
 
     ipSummarizer->clear();
     for(Summarizer* s : summarizers) {
@@ -335,8 +343,8 @@ void Logstalgia::reset() {
 
     highscore = 0u;
 
-    initPaddles();
     initRequestBalls();
+    initPaddles();
 
     ipSummarizer->recalc_display();
 
@@ -482,15 +490,20 @@ void Logstalgia::loadConfig(const std::string& config_file) {
                 throw ConfFileException("cannot change streaming mode at run time", config_file, 0);
             }
 
-            SeekLog* new_seeklog = 0;
+            SeekableLog* new_seeklog = 0;
 
             try {
-                new_seeklog = new SeekLog(new_settings.path);
+                new_seeklog = SeekableLog::open(new_settings.path);
             }
             catch(SeekLogException& e) {
                 throw ConfFileException("unable to read log file", config_file, 0);
             }
 
+            if(logreader != 0) {
+                delete logreader;
+                logreader = 0;
+            }
+
             if(seeklog != 0) delete seeklog;
             seeklog = new_seeklog;
 
@@ -615,6 +628,12 @@ void Logstalgia::seekTo(float percent) {
 
     reset();
 
+    //stop reading ahead from the previous position
+    if(logreader != 0) {
+        delete logreader;
+        logreader = 0;
+    }
+
     seeklog->seekTo(percent);
 
     readLog();
@@ -656,26 +675,27 @@ void Logstalgia::mouseClick(SDL_MouseButtonEvent *e) {
 
             filteredSummarizer->clear();
 
-            for(RequestBall* ball : balls) {
+            if(request_window != 0) {
+                addWindowStrings(filteredSummarizer);
+            } else {
+                for(size_t i=0; i<balls.size(); i++) {
+
+                    LogEntry* le = balls.getLogEntry(i);
 
-                LogEntry* le = ball->getLogEntry();
+                    Summarizer* groupSummarizer = getGroupSummarizer(le);
 
-                Summarizer* groupSummarizer = getGroupSummarizer(le);
+                    if(!groupSummarizer) continue;
 
-                if(!groupSummarizer) continue;
-                if(!ipSummarizer->supportedString(le->hostname)) continue;
-                if(!ipSummarizer->matchesPrefixFilter(le->hostname)) continue;
+                    const std::string& hostname = le->hostname.str();
 
-                if(filteredSummarizer == groupSummarizer) {
+                    if(!ipSummarizer->supportedString(hostname)) continue;
+                    if(!ipSummarizer->matchesPrefixFilter(hostname)) continue;
 
-                    if(settings.hide_url_prefix) {
-                        groupSummarizer->addString(filterURLHostname(le->path));
-                    } else {
-                        groupSummarizer->addString(le->path);
+                    if(filteredSummarizer == groupSummarizer) {
+                        groupSummarizer->addString(le->display_path);
+                    } else if(filteredSummarizer == ipSummarizer) {
+                        ipSummarizer->addString(le->hostname);
                     }
-
-                } else if(filteredSummarizer == ipSummarizer) {
-                    ipSummarizer->addString(le->hostname);
                 }
             }
 
@@ -694,25 +714,19 @@ std::string Logstalgia::dateAtPosition(float percent) {
 
     std::string date;
 
-    if(seeklog == 0 || accesslog == 0) return date;
+    if(seeklog == 0 || accesslog == 0 || logreader == 0) return date;
 
     //get line at position
 
     std::string linestr;
 
-    if(percent<1.0 && seeklog->getNextLineAt(linestr, percent)) {
+    if(percent<1.0 && logreader->getNextLineAt(linestr, percent)) {
 
-        filterLogLine(linestr);
+        LogReader::filterLine(linestr);
 
         LogEntry le;
 
-        set_utc_tz();
-
-        bool parsed = accesslog->parseLine(linestr, le);
-
-        unset_utc_tz();
-
-        if(parsed) {
+        if(accesslog->parseLine(linestr, le)) {
             //display date
             char datestr[256];
 
@@ -745,9 +759,7 @@ void Logstalgia::changePaddleX(float x) {
         it.second->setX(paddle_offset);
     }
 
-    for(RequestBall* ball: balls) {
-        ball->changeDestX(paddle_offset);
-    }
+    balls.changeDestX(paddle_offset);
 }
 
 void Logstalgia::mouseMove(SDL_MouseMotionEvent *e) {
@@ -765,6 +777,9 @@ void Logstalgia::mouseMove(SDL_MouseMotionEvent *e) {
             if(slider.mouseMove(mousepos, &pos)) {
                 std::string date = dateAtPosition(pos);
                 slider.setCaption(date);
+
+                peek_position = pos;
+                peek_pending  = true;
             }
         }
     }
@@ -794,59 +809,50 @@ void Logstalgia::mouseMove(SDL_MouseMotionEvent *e) {
     }
 }
 
-Regex ls_url_hostname_regex("^https?://[^/]+(.+)$");
 
-std::string Logstalgia::filterURLHostname(const std::string& hostname) {
+// first group whose regular expression matches the hostname, response code or path of the entry
+int Logstalgia::findGroup(LogEntry* le) {
 
-    std::vector<std::string> matches;
+    if(!host_groups.empty()) {
+        const std::string& hostname = le->hostname.str();
 
-    if(ls_url_hostname_regex.match(hostname, &matches)) {
-        return matches[0];
+        for(int group : host_groups) {
+            if(summarizers[group]->supportedString(hostname)) return group;
+        }
     }
 
-    return hostname;
-}
-
-Summarizer* Logstalgia::getGroupSummarizer(LogEntry* le) {
-
-    auto host_match_summarizers = summarizer_types["HOST"];
-    auto code_match_summarizers = summarizer_types["CODE"];
-    auto uri_match_summarizers  = summarizer_types["URI"];
-
-    Summarizer* summarizer = 0;
+    if(!code_groups.empty()) {
+        std::string response_code = le->response_code.to_string();
 
-    if(host_match_summarizers != 0) {
-        for(Summarizer* s : *host_match_summarizers) {
-            if(s->supportedString(le->hostname)) {
-                summarizer = s;
-                break;
-            }
+        for(int group : code_groups) {
+            if(summarizers[group]->supportedString(response_code)) return group;
         }
     }
 
-    if(!summarizer && code_match_summarizers != 0) {
-        for(Summarizer* s : *code_match_summarizers) {
-            if(s->supportedString(le->response_code)) {
-                summarizer = s;
-                break;
-            }
-        }
+    const std::string& path = le->path.str();
+
+    for(int group : uri_groups) {
+        if(summarizers[group]->supportedString(path)) return group;
     }
 
-    if(!summarizer && uri_match_summarizers != 0) {
-        for(Summarizer* s : *uri_match_summarizers) {
-            if(s->supportedString(le->path)) {
-                summarizer = s;
-                break;
-            }
-        }
+    return -1;
+}
+
+Summarizer* Logstalgia::getGroupSummarizer(LogEntry* le) {
+
+    // the group of an entry is looked up once and cached on the entry
+    if(le->group_version != group_version) {
+        le->group         = findGroup(le);
+        le->group_version = group_version;
     }
 
+    if(le->group < 0) return 0;
+
+    Summarizer* summarizer = summarizers[le->group];
+
     // must also match prefix filter if there is one
-    if(summarizer != 0) {
-        if(!summarizer->matchesPrefixFilter(le->path)) {
-            return 0;
-        }
+    if(!summarizer->matchesPrefixFilter(le->display_path.str())) {
+        return 0;
     }
 
     return summarizer;
@@ -858,19 +864,67 @@ void Logstalgia::addStrings(LogEntry* le) {
 
     if(!groupSummarizer) return;
 
-    const std::string& hostname = le->hostname;
-    const std::string& pageurl  = le->path;
+    const std::string& hostname = le->hostname.str();
 
     if(!ipSummarizer->supportedString(hostname)) return;
     if(!ipSummarizer->matchesPrefixFilter(hostname)) return;
 
-    if(settings.hide_url_prefix) {
-        groupSummarizer->addString(filterURLHostname(pageurl));
-    } else {
-        groupSummarizer->addString(pageurl);
+    added_strings.add(groupSummarizer, le->display_path);
+
+    added_strings.add(ipSummarizer, le->hostname);
+
+    if(request_window != 0) {
+        request_window->add(groupSummarizer, le->display_path, le->hostname);
     }
+}
+
+// reinsert the requests in the summary window into a cleared summarizer
+void Logstalgia::addWindowStrings(Summarizer* summarizer) {
+
+    std::vector<RequestWindowEntry*> entries;
+    request_window->getEntries(entries);
+
+    for(RequestWindowEntry* entry : entries) {
+
+        if(summarizer != entry->group && summarizer != ipSummarizer) continue;
+
+        const std::string& hostname = entry->hostname.str();
+
+        bool counted = entry->group->matchesPrefixFilter(entry->path.str())
+                    && ipSummarizer->supportedString(hostname)
+                    && ipSummarizer->matchesPrefixFilter(hostname);
 
-    ipSummarizer->addString(hostname);
+        // the summarizer was cleared, record if the entry is counted in it again
+        if(summarizer == entry->group) {
+            entry->in_group = counted;
+            if(counted) summarizer->addString(entry->path, entry->count);
+        } else {
+            entry->in_hosts = counted;
+            if(counted) summarizer->addString(entry->hostname, entry->count);
+        }
+    }
+}
+
+// remove the requests of the seconds that have left the summary window
+void Logstalgia::expireStrings() {
+
+    std::vector<RequestWindowEntry> expired;
+
+    request_window->advance(currtime, expired);
+
+    // remove requests only from the summarizers they are still counted in
+    for(const RequestWindowEntry& entry : expired) {
+
+        if(entry.in_group) {
+            removed_strings.add(entry.group, entry.path, entry.count);
+        }
+
+        if(entry.in_hosts) {
+            removed_strings.add(ipSummarizer, entry.hostname, entry.count);
+        }
+    }
+
+    removed_strings.removeStrings();
 }
 
 void Logstalgia::addBall(LogEntry* le, float start_offset) {
@@ -880,14 +934,16 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
 
     if(!groupSummarizer) return;
 
-    if(!ipSummarizer->supportedString(le->hostname)) return;
-    if(!ipSummarizer->matchesPrefixFilter(le->hostname)) return;
+    const std::string& hostname = le->hostname.str();
+
+    if(!ipSummarizer->supportedString(hostname)) return;
+    if(!ipSummarizer->matchesPrefixFilter(hostname)) return;
 
     Paddle* entry_paddle = 0;
 
     if(settings.paddle_mode > PADDLE_SINGLE) {
 
-        std::string paddle_token = (settings.paddle_mode == PADDLE_VHOST) ? le->vhost : le->pid;
+        const InternedString& paddle_token = (settings.paddle_mode == PADDLE_VHOST) ? le->vhost : le->pid;
 
         entry_paddle = paddles[paddle_token];
 
@@ -898,15 +954,10 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
         }
 
     } else {
-        entry_paddle = paddles[""];
+        entry_paddle = paddles[InternedString()];
     }
 
-    std::string hostname = le->hostname;
-    std::string pageurl  = le->path;
-
-    if(settings.hide_url_prefix) pageurl = filterURLHostname(pageurl);
-
-    float dest_y = groupSummarizer->getMiddlePosY(pageurl);
+    float dest_y = groupSummarizer->getMiddlePosY(le->display_path.str());
     float pos_y  = ipSummarizer->getMiddlePosY(hostname);
 
     float start_x = -(entry_paddle->getX() * settings.pitch_speed * start_offset);
@@ -920,9 +971,9 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
 
     vec3 colour = groupSummarizer->hasColour() ? groupSummarizer->getColour() : colourHash(match);
 
-    RequestBall* ball = new RequestBall(le, colour, ball_start, ball_dest);
+    entry_paddle->addBall();
 
-    balls.push_back(ball);
+    balls.add(le, entry_paddle->getToken(), colour, ball_start, ball_dest);
 }
 
 BaseLog* Logstalgia::getLog() {
@@ -932,101 +983,59 @@ BaseLog* Logstalgia::getLog() {
 }
 
 
-void Logstalgia::filterLogLine(std::string& line) {
-    for(char& c : line) {
-        if(c & 0x80) c = '?';
-    }
-}
-
 void Logstalgia::readLog(int buffer_rows) {
 
     profile_start("readLog");
 
-    set_utc_tz();
+    if(logreader == 0) {
+        logreader = new LogReader(getLog(), settings.path);
+    }
 
     int entries_read = 0;
 
-    std::string linestr;
-    BaseLog* baselog = getLog();
-
     time_t read_timestamp = 0;
 
-    while( baselog->getNextLine(linestr) ) {
+    //lines are parsed ahead by the reader's threads. only wait for them
+    //when reading up to the next timestamp, partial reads take what is ready
+    bool wait = buffer_rows == 0;
 
-        filterLogLine(linestr);
+    LogEntry* le;
 
-        //trim whitespace
-        if(!linestr.empty()) {
-            size_t string_end =
-                linestr.find_last_not_of(" \t\f\v\n\r");
+    while( (le = logreader->getNextEntry(wait)) != 0 ) {
 
-            if(string_end == std::string::npos) {
-                linestr = "";
-            } else if(string_end != linestr.size()-1) {
-                linestr = linestr.substr(0,string_end+1);
-            }
-        }
+        if((!mintime || mintime <= le->timestamp) && (!settings.stop_time || settings.stop_time > le->timestamp)) {
 
-        LogEntry le;
+            time_t timestamp = le->timestamp;
 
-        bool parsed_entry;
+            queued_entries.push_back(le);
 
-        //determine format
-        if(accesslog==0) {
+            total_entries++;
+            entries_read++;
 
-            //is this a recognized NCSA access log?
-            NCSALog* ncsalog = new NCSALog();
-            if((parsed_entry = ncsalog->parseLine(linestr, le))) {
-                accesslog = ncsalog;
+            //read at least the buffered row count if specified
+            //otherwise read all entries with the same time
+            if(buffer_rows) {
+                if(entries_read > buffer_rows) break;
             } else {
-                delete ncsalog;
+                if(read_timestamp && read_timestamp < timestamp) break;
             }
 
-            if(accesslog==0) {
-                //is this a custom log?
-                CustomAccessLog* customlog = new CustomAccessLog();
-                if((parsed_entry = customlog->parseLine(linestr, le))) {
-                    accesslog = customlog;
-                } else {
-                    delete customlog;
-                }
-            }
+            read_timestamp = timestamp;
 
         } else {
-
-            if(!(parsed_entry = accesslog->parseLine(linestr, le))) {
-                debugLog("error: could not read line %s\n", linestr.c_str());
-            }
-        }
-
-        if(parsed_entry) {
-
-            if((!mintime || mintime <= le.timestamp) && (!settings.stop_time || settings.stop_time > le.timestamp)) {
-
-                queued_entries.push_back(new LogEntry(le));
-
-                total_entries++;
-                entries_read++;
-
-                //read at least the buffered row count if specified
-                //otherwise read all entries with the same time
-                if(buffer_rows) {
-                    if(entries_read > buffer_rows) break;
-                } else {
-                    if(read_timestamp && read_timestamp < le.timestamp) break;
-                }
-
-                read_timestamp = le.timestamp;
-            }
+            delete le;
         }
     }
 
-    profile_stop();
+    if(accesslog == 0) accesslog = logreader->createAccessLog();
 
-    unset_utc_tz();
+    profile_stop();
 
     if(queued_entries.empty() && seeklog != 0) {
 
+        //entries may still be being parsed
+        if(!logreader->isFinished()) return;
+
         if(total_entries==0) {
             if(mintime != 0) {
                 logstalgia_quit("could not parse any entries in the specified time period");
@@ -1038,11 +1047,13 @@ void Logstalgia::readLog(int buffer_rows) {
         //no more entries
         end_reached = true;
 
+        debugLog("%d of %d lines could not be parsed", logreader->getFailedLineCount(), logreader->getLineCount());
+
         return;
     }
 
     if(seeklog != 0) {
-        float percent = seeklog->getPercent();
+        float percent = logreader->getPercent();
 
         if(percent > settings.stop_position) {
             end_reached = true;
@@ -1093,11 +1104,25 @@ void Logstalgia::init() {
 
     ipSummarizer->setSize(2, 40, 0);
 
+    if(request_window != 0) {
+        delete request_window;
+        request_window = 0;
+    }
+
+    if(settings.summary_window > 0) {
+        request_window = new RequestWindow(settings.summary_window);
+    }
+
     for(Summarizer* s : summarizers) {
         delete s;
     }
     summarizers.clear();
-    summarizer_types.clear();
+
+    host_groups.clear();
+    code_groups.clear();
+    uri_groups.clear();
+
+    group_version++;
 
     for(const SummarizerGroup& group : settings.groups) {
         addGroup(group);
@@ -1153,6 +1178,13 @@ void Logstalgia::init() {
     initialized = true;
 }
 
+// release the ball and glow buffers before the gl context is recreated
+void Logstalgia::unloadBuffers() {
+
+    ball_vbo.unload();
+    glow_vbo.unload();
+}
+
 void Logstalgia::toggleFullscreen() {
 
     if(frameExporter != 0) return;
@@ -1161,6 +1193,8 @@ void Logstalgia::toggleFullscreen() {
     shadermanager.unload();
     fontmanager.unload();
 
+    unloadBuffers();
+
     //recreate gl context
     display.toggleFullscreen();
 
@@ -1177,6 +1211,8 @@ void Logstalgia::resize(int width, int height) {
     shadermanager.unload();
     fontmanager.unload();
 
+    unloadBuffers();
+
     display.resize(width, height);
 
     texturemanager.reload();
@@ -1196,6 +1232,8 @@ void Logstalgia::toggleWindowFrame() {
     shadermanager.unload();
     fontmanager.unload();
 
+    unloadBuffers();
+
     display.toggleFrameless();
 
     texturemanager.reload();
@@ -1209,8 +1247,8 @@ void Logstalgia::toggleWindowFrame() {
 }
 
 void Logstalgia::reposition() {
-    initPaddles();
     initRequestBalls();
+    initPaddles();
     resizeSummarizers();
     slider.resize();
 }
@@ -1258,54 +1296,29 @@ void Logstalgia::update(float t, float dt) {
    framecount++;
 }
 
-RequestBall* Logstalgia::findNearest(Paddle* paddle, const std::string& paddle_token) {
-
-    float min_arrival = -1.0f;
-    RequestBall* nearest = 0;
-
-    for(RequestBall* ball: balls) {
+void Logstalgia::removeBall(size_t ball) {
 
-        LogEntry* le = ball->getLogEntry();
+    LogEntry* le = balls.getLogEntry(ball);
 
-        //special case if failed response code
-        if(!le->successful) {
-            continue;
-        }
+    auto paddle = paddles.find(balls.getPaddleToken(ball));
 
-        if(le->successful && !ball->hasBounced()
-            && (   (settings.paddle_mode <= PADDLE_SINGLE)
-                || (settings.paddle_mode == PADDLE_VHOST && le->vhost == paddle_token)
-                || (settings.paddle_mode == PADDLE_PID   && le->pid   == paddle_token)
-               )
-            ) {
-
-            float arrival = ball->arrivalTime();
-
-            if(min_arrival<0.0f || arrival<min_arrival) {
-                min_arrival = arrival;
-                nearest = ball;
-            }
-        }
+    if(paddle != paddles.end()) {
+        paddle->second->removeBall();
     }
 
-    return nearest;
-}
-
-void Logstalgia::removeBall(RequestBall* ball) {
-
-    LogEntry* le = ball->getLogEntry();
+    // requests in the summary window expire with it
+    if(request_window == 0) {
 
-    if(Summarizer* s = getGroupSummarizer(le)) {
-        std::string url = le->path;
-        if(settings.hide_url_prefix) url = filterURLHostname(url);
-        s->removeString(url);
-    }
+        if(Summarizer* s = getGroupSummarizer(le)) {
+            removed_strings.add(s, le->display_path);
+        }
 
-    if(ipSummarizer->supportedString(le->hostname)) {
-        ipSummarizer->removeString(le->hostname);
+        if(ipSummarizer->supportedString(le->hostname.str())) {
+            removed_strings.add(ipSummarizer, le->hostname);
+        }
     }
 
-    delete ball;
+    balls.remove(ball);
 }
 
 void Logstalgia::logic(float t, float dt) {
@@ -1331,6 +1344,12 @@ void Logstalgia::logic(float t, float dt) {
         }
     }
 
+    //update the slider caption once the line peeked at has been read
+    if(peek_pending && logreader != 0) {
+        peek_pending = logreader->isPeeking();
+        slider.setCaption(dateAtPosition(peek_position));
+    }
+
     infowindow.hide();
 
     if(end_reached && balls.empty()) {
@@ -1353,11 +1372,7 @@ void Logstalgia::logic(float t, float dt) {
                 }
             }
 
-            for(RequestBall* ball : balls) {
-                if(ball->mouseOver(infowindow, mousepos)) {
-                    break;
-                }
-            }
+            balls.mouseOver(infowindow, mousepos);
         }
 
         // inspect summarizer detail
@@ -1394,6 +1409,12 @@ void Logstalgia::logic(float t, float dt) {
             readLog();
         }
 
+        if(request_window != 0) {
+            profile_start("expire summary window");
+            expireStrings();
+            profile_stop();
+        }
+
         profile_start("determine new entries");
 
         int items_to_spawn=0;
@@ -1407,6 +1428,8 @@ void Logstalgia::logic(float t, float dt) {
             addStrings(le);
         }
 
+        added_strings.addStrings();
+
         profile_stop();
 
         //debugLog("items to spawn %d\n", items_to_spawn);
@@ -1416,11 +1439,13 @@ void Logstalgia::logic(float t, float dt) {
             profile_start("add new strings");
 
             //re-summarize
-            ipSummarizer->summarize();
+            std::vector<Summarizer*> all_summarizers;
+            all_summarizers.reserve(summarizers.size() + 1);
 
-            for(Summarizer* s : summarizers) {
-                s->summarize();
-            }
+            all_summarizers.push_back(ipSummarizer);
+            all_summarizers.insert(all_summarizers.end(), summarizers.begin(), summarizers.end());
+
+            summarizer_pool->summarize(all_summarizers);
 
             profile_stop();
 
@@ -1472,71 +1497,54 @@ void Logstalgia::logic(float t, float dt) {
         }
     }
 
-    std::list<Paddle*> inactivePaddles;
-
     //update paddles
-    for(auto& it: paddles) {
-
-        std::string paddle_token = it.first;
-        Paddle*           paddle = it.second;
-
-        if(settings.paddle_mode > PADDLE_SINGLE && !paddle->moving() && !paddle->visible()) {
+    for(auto it = paddles.begin(); it != paddles.end();) {
 
-            bool token_match = false;
-
-            //are there any requests that will match this paddle?
-            for(RequestBall* ball : balls) {
-
-                LogEntry* le = ball->getLogEntry();
-
-                if(   (settings.paddle_mode == PADDLE_VHOST && le->vhost == paddle_token)
-                   || (settings.paddle_mode == PADDLE_PID   && le->pid   == paddle_token)) {
-                    token_match = true;
-                    break;
-                }
-            }
+        Paddle*                     paddle = it->second;
+        const InternedString& paddle_token = paddle->getToken();
 
-            //mark this paddle for deletion, continue
-            if(!token_match) {
-                inactivePaddles.push_back(paddle);
-                continue;
-            }
+        //retire idle paddles with no requests heading to them
+        if(   settings.paddle_mode > PADDLE_SINGLE && !paddle->moving() && !paddle->visible()
+           && paddle->getBallCount() == 0) {
+            delete paddle;
+            it = paddles.erase(it);
+            continue;
         }
 
         // find nearest ball to this paddle
-        if( (retarget || !paddle->getTarget())) {
+        if( (retarget || !paddle->hasTarget())) {
 
-            RequestBall* ball = findNearest(paddle, paddle_token);
+            size_t ball;
 
-            if(ball != 0) {
-                paddle->setTarget(ball);
+            if(balls.findNearest(paddle_token, ball)) {
+                paddle->setTarget(balls.getFinishPos(ball), balls.getColour(ball), balls.arrivalTime(ball));
             } else if(!paddle->moving()) {
-                paddle->setTarget(0);
+                paddle->clearTarget();
             }
         }
 
         paddle->logic(sdt);
+
+        it++;
     }
 
     retarget = false;
 
     profile_start("check ball status");
 
-    // NOTE: special handling for this iterator as items are being removed
-    for(auto it = balls.begin(); it != balls.end();) {
-
-        RequestBall* ball = *it;
-
-        highscore += ball->logic(sdt);
+    highscore += balls.logic(sdt);
 
-        if(ball->isFinished()) {
-            it = balls.erase(it);
-            removeBall(ball);
+    // NOTE: removing a ball moves the last ball to its index
+    for(size_t i=0; i<balls.size();) {
+        if(balls.isFinished(i)) {
+            removeBall(i);
         } else {
-            it++;
+            i++;
         }
     }
 
+    removed_strings.removeStrings();
+
     profile_stop();
 
     profile_start("ipSummarizer logic");
@@ -1595,12 +1603,17 @@ void Logstalgia::addGroup(const std::string& group_type, const std::string& grou
         summarizer->setColour(colour);
     }
 
-    if(!summarizer_types[group_type]) {
-        summarizer_types[group_type] = new std::vector<Summarizer*>();
+    int group = summarizers.size();
+
+    if(group_type == "HOST") {
+        host_groups.push_back(group);
+    } else if(group_type == "CODE") {
+        code_groups.push_back(group);
+    } else if(group_type == "URI") {
+        uri_groups.push_back(group);
     }
 
     summarizers.push_back(summarizer);
-    summarizer_types[group_type]->push_back(summarizer);
 
     int space = (int) ( ((float)percent/100) * total_space );
     remaining_space -= space;
@@ -1680,8 +1693,11 @@ void Logstalgia::draw(float t, float dt) {
 
     glBindTexture(GL_TEXTURE_2D, balltex->textureid);
 
-    for(RequestBall* ball : balls) {
-        ball->draw();
+    if(settings.ffp) {
+        balls.draw();
+    } else {
+        balls.updateVBO(ball_vbo, balltex->textureid);
+        ball_vbo.draw();
     }
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -1689,6 +1705,10 @@ void Logstalgia::draw(float t, float dt) {
     profile_stop();
 
 
+    //text is added to the font manager's buffer and drawn with
+    //one call per glyph texture, unless using the fixed function pipeline
+    if(!settings.ffp) fontmanager.startBuffer();
+
     profile_start("draw ip summarizer");
 
     ipSummarizer->draw(dt, font_alpha);
@@ -1705,16 +1725,17 @@ void Logstalgia::draw(float t, float dt) {
 
     profile_start("draw response codes");
 
-    for(std::list<RequestBall*>::iterator it = balls.begin(); it != balls.end(); it++) {
-        RequestBall* r = *it;
-
-        if(!settings.hide_response_code && r->hasBounced()) {
-            r->drawResponseCode(&fontMedium);
-        }
+    if(!settings.hide_response_code) {
+        balls.drawResponseCodes(&fontMedium);
     }
 
     profile_stop();
 
+    if(!settings.ffp) {
+        fontmanager.commitBuffer();
+        fontmanager.drawBuffer();
+    }
+
     glDisable(GL_TEXTURE_2D);
     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_BLEND);
@@ -1736,10 +1757,17 @@ void Logstalgia::draw(float t, float dt) {
 
         glEnable(GL_TEXTURE_2D);
 
+        if(!settings.ffp) fontmanager.startBuffer();
+
         //draw paddle tokens
         for(auto& it: paddles) {
             it.second->drawToken();
         }
+
+        if(!settings.ffp) {
+            fontmanager.commitBuffer();
+            fontmanager.drawBuffer();
+        }
     }
 
     if(!settings.disable_glow) {
@@ -1751,8 +1779,11 @@ void Logstalgia::draw(float t, float dt) {
 
         glBindTexture(GL_TEXTURE_2D, glowtex->textureid);
 
-        for(std::list<RequestBall*>::iterator it = balls.begin(); it != balls.end(); it++) {
-            (*it)->drawGlow();
+        if(settings.ffp) {
+            balls.drawGlow();
+        } else {
+            balls.updateGlowVBO(glow_vbo, glowtex->textureid);
+            glow_vbo.draw();
         }
     }
 
@@ -1807,6 +1838,14 @@ void Logstalgia::draw(float t, float dt) {
         fontMedium.print(2,53,"Paddles: %d", paddles.size());
         fontMedium.print(2,70,"Simulation Speed: %.2f", settings.simulation_speed);
         fontMedium.print(2,87,"Pitch Speed: %.2f", settings.pitch_speed);
+        fontMedium.print(2,104,"Strings: %d (%d unique)", (int) intern_table.getTotalCount(), (int) intern_table.getUniqueCount());
+
+        if(logreader != 0) {
+            int line_count   = logreader->getLineCount();
+            int failed_count = logreader->getFailedLineCount();
+
+            fontMedium.print(2,121,"Unparsed Lines: %d (%.1f%%)", failed_count, line_count > 0 ? 100.0f * failed_count / line_count : 0.0f);
+        }
     } else {
         fontMedium.draw(2,2,  displaydate.c_str());
         fontMedium.draw(2,19, displaytime.c_str());
@@ -20,13 +20,16 @@
 
 #include "core/sdlapp.h"
 #include "core/fxfont.h"
-#include "core/seeklog.h"
 #include "core/ppm.h"
 
 #include "logentry.h"
+#include "logreader.h"
+#include "seekablelog.h"
 #include "paddle.h"
 #include "requestball.h"
 #include "summarizer.h"
+#include "summarizerpool.h"
+#include "requestwindow.h"
 #include "textarea.h"
 #include "slider.h"
 #include "settings.h"
@@ -34,14 +37,14 @@
 #include <string>
 #include <vector>
 #include <list>
-#include <map>
+#include <unordered_map>
 #include <time.h>
 
 class ConfigWatcher;
 
 class Logstalgia : public SDLApp {
 
-    std::map<std::string,Paddle*> paddles;
+    std::unordered_map<InternedString,Paddle*,InternedStringHash> paddles;
 
     std::string logfile;
 
@@ -87,11 +90,19 @@ class Logstalgia : public SDLApp {
     TextureResource* balltex;
     TextureResource* glowtex;
 
+    // balls and glows drawn in one call each unless using the fixed function pipeline
+    quadbuf ball_vbo;
+    quadbuf glow_vbo;
+
     float toggle_delay;
 
     float mousehide_timeout;
     vec2 mousepos;
 
+    // slider position of the last line peeked at, until its date is shown
+    float peek_position;
+    bool peek_pending;
+
     FXFont fontSmall;
     FXFont fontMedium;
     FXFont fontLarge;
@@ -104,17 +115,35 @@ class Logstalgia : public SDLApp {
     Summarizer* ipSummarizer;
 
     std::vector<Summarizer*> summarizers;
-    std::map<std::string, std::vector<Summarizer*>*> summarizer_types;
+
+    // indexes of the group summarizers matched against each field of an entry, in order
+    std::vector<int> host_groups;
+    std::vector<int> code_groups;
+    std::vector<int> uri_groups;
+
+    // changed whenever the groups are redefined, invalidating the groups cached on entries
+    int group_version;
+
+    SummarizerPool* summarizer_pool;
 
     PositionSlider slider;
 
     AccessLog* accesslog;
 
-    SeekLog* seeklog;
+    SeekableLog* seeklog;
     StreamLog* streamlog;
 
+    LogReader* logreader;
+
     std::list<LogEntry*> queued_entries;
-    std::list<RequestBall*> balls;
+    RequestBalls balls;
+
+    // strings of new and finished requests, added to and removed from the summarizers together
+    SummBatch added_strings;
+    SummBatch removed_strings;
+
+    // requests summarized with --summary-window, 0 to summarize requests in flight
+    RequestWindow* request_window;
 
     TextArea infowindow;
 
@@ -129,25 +158,23 @@ class Logstalgia : public SDLApp {
 
     bool hasProgressBar();
 
-    std::string filterURLHostname(const std::string& hostname);
-
     std::string dateAtPosition(float percent);
     void seekTo(float percent);
 
-    void filterLogLine(std::string& line);
-
     void readLog(int buffer_rows = 0);
 
-    RequestBall* findNearest(Paddle* paddle, const std::string& paddle_token);
     void updateGroups(float dt);
     void drawGroups(float dt, float alpha);
 
+    int findGroup(LogEntry* le);
     Summarizer* getGroupSummarizer(LogEntry* le);
 
     void addStrings(LogEntry* le);
+    void addWindowStrings(Summarizer* summarizer);
+    void expireStrings();
 
     void addBall(LogEntry* le,  float start_offset);
-    void removeBall(RequestBall* ball);
+    void removeBall(size_t ball);
     void addGroup(const SummarizerGroup& group);
     void addGroup(const std::string& group_type, const std::string& group_title, const std::string& group_regex, const std::string& separators, int max_depth, int abbrev_depth, int percent = 0, vec3 colour = vec3(0.0f, 0.0f, 0.0f));
     void togglePause();
@@ -186,6 +213,7 @@ class Logstalgia : public SDLApp {
 
     void screenshot();
 
+    void unloadBuffers();
     void toggleFullscreen();
 
     void logic(float t, float dt);
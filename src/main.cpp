@@ -18,6 +18,7 @@
 #include "logstalgia.h"
 #include "settings.h"
 #include "tests.h"
+#include "benchmark.h"
 
 #ifdef _WIN32
 std::string win32LogSelector() {
@@ -182,6 +183,18 @@ int main(int argc, char *argv[]) {
          display.quit();
          exit(0);
      }
+
+    // run benchmarks
+    if(settings.run_benchmarks) {
+        LogstalgiaBenchmark benchmark;
+        try {
+            benchmark.run();
+        } catch(std::exception& e) {
+            SDLAppQuit(e.what());
+        }
+        display.quit();
+        exit(0);
+    }
      
     //disable OpenGL 2.0 functions if not supported
     if(!GLEW_VERSION_2_0) settings.ffp = true;
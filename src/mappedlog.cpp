@@ -0,0 +1,271 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mappedlog.h"
+#include "linescanner.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+// reads of a mapping fault with SIGBUS past the end of a file truncated after it was mapped.
+// while a thread reads from a mapping the handler jumps back to the read, failing it
+
+thread_local sigjmp_buf* mapped_log_jump = 0;
+
+struct sigaction mapped_log_previous_action;
+
+static void mapped_log_sigbus(int sig, siginfo_t* info, void* context) {
+
+    if(mapped_log_jump != 0) {
+        siglongjmp(*mapped_log_jump, 1);
+    }
+
+    //not reading a mapping, the fault is re-raised with the previous handler on return
+    sigaction(SIGBUS, &mapped_log_previous_action, 0);
+}
+
+static void mapped_log_install_handler() {
+
+    static bool installed = false;
+
+    if(installed) return;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+
+    action.sa_sigaction = mapped_log_sigbus;
+
+    //not blocked in the handler as the jump doesn't restore the signal mask
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+
+    sigemptyset(&action.sa_mask);
+
+    sigaction(SIGBUS, &action, &mapped_log_previous_action);
+
+    installed = true;
+}
+
+// marks the current thread as reading a mapping while in scope.
+// a read that faults returns to the sigsetjmp that follows the guard
+class MappedLogGuard {
+public:
+    sigjmp_buf env;
+
+    MappedLogGuard() {
+        mapped_log_jump = &env;
+    }
+
+    ~MappedLogGuard() {
+        mapped_log_jump = 0;
+    }
+};
+
+#endif
+
+MappedLog::MappedLog(int fd, const char* data, size_t size)
+    : fd(fd), data(data), mapped_size(size), size(size), offset(0) {
+
+#ifndef _WIN32
+    page_size = sysconf(_SC_PAGESIZE);
+#else
+    page_size = 4096;
+#endif
+
+    adviseSequential();
+}
+
+MappedLog::~MappedLog() {
+#ifndef _WIN32
+    munmap((void*) data, mapped_size);
+    close(fd);
+#endif
+}
+
+MappedLog* MappedLog::open(const std::string& path) {
+#ifdef _WIN32
+    return 0;
+#else
+    struct stat file_stat;
+
+    //opening a named pipe would block until it has a writer
+    if(stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) return 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if(fd == -1) return 0;
+
+    if(fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0 || (uint64_t) file_stat.st_size > SIZE_MAX) {
+        close(fd);
+        return 0;
+    }
+
+    size_t size = file_stat.st_size;
+
+    void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if(data == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    mapped_log_install_handler();
+
+    debugLog("mapped %s (%lu bytes)", path.c_str(), (unsigned long) size);
+
+    //the file is kept open to find its size if it is truncated
+    return new MappedLog(fd, (const char*) data, size);
+#endif
+}
+
+//the file was truncated while being read, end at its new size
+void MappedLog::truncated() {
+#ifndef _WIN32
+    struct stat file_stat;
+
+    size_t file_size = fstat(fd, &file_stat) == 0 ? (size_t) file_stat.st_size : 0;
+
+    //only ever shrinks, the reader clamps its own offset to it
+    size_t log_size = size;
+    while(file_size < log_size && !size.compare_exchange_weak(log_size, file_size));
+
+    debugLog("log truncated while being read");
+#endif
+}
+
+void MappedLog::adviseSequential() {
+#ifndef _WIN32
+    size_t log_size = size;
+    size_t start    = offset - offset % page_size;
+
+    if(start >= log_size) return;
+
+    posix_madvise((void*) (data + start), log_size - start, POSIX_MADV_SEQUENTIAL);
+    posix_madvise((void*) (data + start), std::min(log_size - start, (size_t) MAPPED_LOG_READAHEAD), POSIX_MADV_WILLNEED);
+#endif
+}
+
+//offset of the first complete line at or after a position
+size_t MappedLog::getLineStart(float percent, size_t log_size) const {
+
+    size_t line_offset = (size_t) ((double) log_size * percent);
+
+    if(line_offset == 0) return 0;
+    if(line_offset >= log_size) return log_size;
+
+    //skip the remainder of a partial line
+    if(data[line_offset-1] != '\n') {
+        line_offset += LineScanner::findLineEnd(data + line_offset, log_size - line_offset) + 1;
+    }
+
+    return std::min(line_offset, log_size);
+}
+
+//copy the line at an offset and return the offset of the following line
+size_t MappedLog::readLine(size_t line_offset, std::string& line, size_t log_size) const {
+
+    size_t length = LineScanner::findLineEnd(data + line_offset, log_size - line_offset);
+
+    //sized first so a faulting copy can't leave the string partly assigned
+    line.resize(length);
+    if(length > 0) memcpy(&line[0], data + line_offset, length);
+
+    return std::min(line_offset + length + 1, log_size);
+}
+
+float MappedLog::getPercent() {
+    size_t log_size = size;
+
+    if(offset >= log_size) return 1.0f;
+
+    return (float) ((double) offset / log_size);
+}
+
+void MappedLog::seekTo(float percent) {
+
+#ifndef _WIN32
+    MappedLogGuard guard;
+
+    if(sigsetjmp(guard.env, 0) != 0) {
+        truncated();
+        return;
+    }
+#endif
+
+    offset = getLineStart(percent, size);
+
+    adviseSequential();
+}
+
+//peeking doesn't change the advice given for playback, it only reads a page or two
+bool MappedLog::getNextLineAt(std::string& line, float percent) {
+
+#ifndef _WIN32
+    MappedLogGuard guard;
+
+    if(sigsetjmp(guard.env, 0) != 0) {
+        truncated();
+        return false;
+    }
+#endif
+
+    size_t log_size    = size;
+    size_t line_offset = getLineStart(percent, log_size);
+
+    if(line_offset >= log_size) return false;
+
+    readLine(line_offset, line, log_size);
+
+    return true;
+}
+
+bool MappedLog::getNextLine(std::string& line) {
+
+    size_t log_size = size;
+
+    if(offset >= log_size) return false;
+
+#ifndef _WIN32
+    MappedLogGuard guard;
+
+    if(sigsetjmp(guard.env, 0) != 0) {
+        truncated();
+        return false;
+    }
+#endif
+
+    offset = readLine(offset, line, log_size);
+
+    return true;
+}
+
+bool MappedLog::isFinished() {
+    return offset >= size;
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPED_LOG_H
+#define MAPPED_LOG_H
+
+#include "seekablelog.h"
+
+#include <atomic>
+#include <string>
+
+//amount of the file to start reading ahead of playback after seeking
+#define MAPPED_LOG_READAHEAD 4194304
+
+// log file mapped into memory. lines are read directly from the mapping so
+// seeking and peeking at a position is just pointer arithmetic.
+// if the file is truncated while being read (eg by logrotate copytruncate) reads
+// of the part that was removed are caught and the log ends as a stream would at EOF.
+// peeks may run on another thread to playback, they only share the size of the file
+
+class MappedLog : public SeekableLog {
+    int fd;
+
+    const char* data;
+    size_t mapped_size;
+    std::atomic<size_t> size;
+    size_t offset;
+    size_t page_size;
+
+    MappedLog(int fd, const char* data, size_t size);
+
+    size_t getLineStart(float percent, size_t log_size) const;
+    size_t readLine(size_t line_offset, std::string& line, size_t log_size) const;
+
+    void truncated();
+
+    void adviseSequential();
+public:
+    ~MappedLog();
+
+    // returns 0 if the file is not a regular file or cannot be mapped
+    static MappedLog* open(const std::string& path);
+
+    float getPercent();
+    void seekTo(float percent);
+
+    bool getNextLineAt(std::string& line, float percent);
+    bool getNextLine(std::string& line);
+    bool isFinished();
+};
+
+#endif
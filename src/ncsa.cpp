@@ -19,7 +19,6 @@
 #include "core/regex.h"
 #include "settings.h"
 
-#include <time.h>
 
 const char* ls_ncsa_months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug" , "Sep", "Oct", "Nov", "Dec" };
 Regex ls_ncsa_entry_start("^(?:([^ ]+) )?([^ ]+) +[^ ]+ +([^ ]+) +\\[(.*?)\\] +(.*)$");
@@ -31,9 +30,328 @@ Regex ls_ncsa_extra_field("^ +(\"[^\"]*\"|[^ ]+)");
 NCSALog::NCSALog() {
 }
 
+AccessLog* NCSALog::clone() const {
+    return new NCSALog();
+}
+
+const char* NCSALog::getFormatName() const {
+    return "ncsa";
+}
+
+//convert month string (numeric or abbreviated name) to range 0-11 as used by mktime
+static int ls_ncsa_month(const std::string& monthstr) {
+
+    int month = atoi(monthstr.c_str());
+
+    if(month) {
+        month--;
+    } else {
+        //parse non numeric month
+        for(int i=0;i<12;i++) {
+            if(strcmp(monthstr.c_str(), ls_ncsa_months[i])==0) {
+                month=i;
+                break;
+            }
+        }
+    }
+
+    return month;
+}
+
+static void ls_ncsa_extract_pid(const std::string& extra, LogEntry& entry) {
+
+    // NOTE: could store extra fields and allow --paddle-mode to address then via their offset
+    if(extra.empty()) return;
+
+    std::vector<std::string> extra_fields;
+    if(ls_ncsa_extra_field.matchAll(extra, &extra_fields)) {
+
+//         for(size_t i=0;i<extra_fields.size();i++) {
+//             debugLog("extra fields %d: %s", i, extra_fields[i].c_str());
+//         }
+
+        if(!extra_fields.empty() && !extra_fields[0].empty()) {
+            std::string pid = extra_fields[0];
+
+            if(pid.size()>=2 && pid[0] == '"' && pid[pid.size()-1] == '"') {
+                pid = pid.substr(1, pid.size()-2);
+            }
+
+            entry.pid = intern_table.intern(pid);
+        }
+    }
+}
+
+//read an unsigned decimal number of at most 9 digits
+static const char* ls_ncsa_read_number(const char* p, int& value) {
+
+    const char* start = p;
+
+    value = 0;
+
+    while(*p >= '0' && *p <= '9') {
+        if(p - start == 9) return 0;
+
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+
+    if(p == start) return 0;
+
+    return p;
+}
+
+//first extra field without surrounding quotes
+static boost::string_view ls_ncsa_first_field(const char* extra) {
+
+    const char* p = extra;
+
+    while(*p == ' ') p++;
+
+    if(*p == '\0') return boost::string_view();
+
+    const char* start = p;
+    const char* end   = 0;
+
+    if(*p == '"') {
+        const char* close = strchr(p+1, '"');
+        if(close != 0) end = close + 1;
+    }
+
+    if(end == 0) {
+        while(*p && *p != ' ') p++;
+        end = p;
+    }
+
+    boost::string_view field(start, end - start);
+
+    if(field.size()>=2 && field.front() == '"' && field.back() == '"') {
+        field = field.substr(1, field.size()-2);
+    }
+
+    return field;
+}
+
+static inline bool ls_ncsa_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+//single pass tokenizer for NCSA common/combined format lines.
+//
+//accepts only the unambiguous layout of the format, returning false for
+//anything else so the line can be given to the regular expression parser.
+//fields are assigned exactly as parseLineRegex would assign them.
+bool NCSALog::tokenizeLine(const std::string& line, LogEntry& entry) {
+
+    const char* p = line.c_str();
+
+    //hostname, ident and user optionally preceded by a vhost, separated by single spaces
+    const char* token_start[4];
+    size_t token_length[4];
+    int token_count = 0;
+
+    while(*p != '[') {
+        if(token_count == 4) return false;
+
+        const char* start = p;
+        while(*p && *p != ' ') p++;
+
+        if(p == start || *p != ' ') return false;
+
+        token_start[token_count]  = start;
+        token_length[token_count] = p - start;
+        token_count++;
+
+        p++;
+    }
+
+    if(token_count < 3) return false;
+
+    //timestamp eg [22/Apr/2009:18:52:51 +1200]
+    p++;
+
+    int day, year, hour, minute, second;
+
+    if(!(p = ls_ncsa_read_number(p, day)) || *p++ != '/') return false;
+
+    const char* month_start = p;
+    if(*p >= '0' && *p <= '9') {
+        while(*p >= '0' && *p <= '9') p++;
+    } else {
+        while((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) p++;
+    }
+    if(p == month_start || p - month_start > 9) return false;
+
+    std::string monthstr(month_start, p - month_start);
+
+    if(*p++ != '/') return false;
+    if(!(p = ls_ncsa_read_number(p, year))   || *p++ != ':') return false;
+    if(!(p = ls_ncsa_read_number(p, hour))   || *p++ != ':') return false;
+    if(!(p = ls_ncsa_read_number(p, minute)) || *p++ != ':') return false;
+    if(!(p = ls_ncsa_read_number(p, second)) || *p++ != ' ') return false;
+
+    char tz_sign = *p++;
+    if(tz_sign != '+' && tz_sign != '-') return false;
+
+    for(int i=0;i<4;i++) {
+        if(p[i] < '0' || p[i] > '9') return false;
+    }
+
+    int tz_hour = (p[0] - '0') * 10 + (p[1] - '0');
+    int tz_min  = (p[2] - '0') * 10 + (p[3] - '0');
+    p += 4;
+
+    if(*p++ != ']' || *p != ' ') return false;
+
+    while(*p == ' ') p++;
+
+    //request eg "GET /index.html HTTP/1.1"
+    if(*p++ != '"') return false;
+
+    const char* request_start[3];
+    size_t request_length[3];
+
+    for(int i=0;i<3;i++) {
+        const char* start = p;
+        while(*p && *p != ' ' && *p != '"') p++;
+
+        if(p == start) return false;
+
+        request_start[i]  = start;
+        request_length[i] = p - start;
+
+        if(i<2) {
+            if(*p != ' ') return false;
+            while(*p == ' ') p++;
+        }
+    }
+
+    if(*p++ != '"' || *p != ' ') return false;
+
+    while(*p == ' ') p++;
+
+    //response code and size
+    const char* code_start = p;
+    while(*p && *p != ' ') p++;
+    if(p == code_start || *p != ' ') return false;
+
+    const char* code_end = p;
+
+    while(*p == ' ') p++;
+
+    const char* size_start = p;
+    while(*p && *p != '+' && !ls_ncsa_is_space(*p)) p++;
+    if(p == size_start) return false;
+
+    //optional quoted referrer and user agent followed by any extra fields
+    const char* agentstr = p;
+    const char* extra    = 0;
+
+    const char* referrer_start = 0;
+    const char* referrer_end   = 0;
+    const char* agent_start    = 0;
+    const char* agent_end      = 0;
+
+    if(*p == ' ') {
+        while(*p == ' ') p++;
+
+        if(*p == '"') {
+            referrer_start = ++p;
+            while(*p && *p != '"') p++;
+
+            if(p > referrer_start && *p == '"') {
+                referrer_end = p++;
+
+                if(*p == ' ') {
+                    while(*p == ' ') p++;
+
+                    if(*p == '"') {
+                        agent_start = ++p;
+                        while(*p && *p != '"') p++;
+
+                        if(p > agent_start && *p == '"') {
+                            agent_end = p++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if(agent_end != 0) {
+        if(p[0] == ' ' && p[1] != '\0') extra = p;
+    } else if(agentstr[0] == ' ' && agentstr[1] != '\0') {
+        extra = agentstr;
+    }
+
+    //convert timestamp
+    int month = ls_ncsa_month(monthstr);
+
+    //could not parse month (range 0-11 as used by mktime)
+    if(month<0 || month>11) return false;
+
+    int tz_offset = tz_hour * 3600 + tz_min * 60;
+
+    if(tz_sign == '-') {
+        tz_offset = -tz_offset;
+    }
+
+    //get details
+    entry.reset();
+
+    if(token_count == 4) {
+        entry.vhost    = intern_table.intern(boost::string_view(token_start[0], token_length[0]));
+        entry.hostname = intern_table.intern(boost::string_view(token_start[1], token_length[1]));
+    } else {
+        entry.hostname = intern_table.intern(boost::string_view(token_start[0], token_length[0]));
+    }
+
+    //the other fields are views of one stored copy of the line
+    boost::string_view stored_line = entry.storeLine(line);
+
+    if(settings.display_log_entry) {
+        entry.log_entry = stored_line;
+    }
+
+    entry.timestamp = toTimestamp(year, month, day, hour, minute, second, tz_offset);
+
+    entry.method   = entry.storeField(boost::string_view(request_start[0], request_length[0]));
+    entry.path     = intern_table.intern(boost::string_view(request_start[1], request_length[1]));
+    entry.protocol = entry.storeField(boost::string_view(request_start[2], request_length[2]));
+
+    entry.response_code = entry.storeField(boost::string_view(code_start, code_end - code_start));
+    entry.response_size = strtol(size_start, 0, 10);
+
+    if(agent_end != 0) {
+        entry.referrer   = entry.storeField(boost::string_view(referrer_start, referrer_end - referrer_start));
+        entry.user_agent = entry.storeField(boost::string_view(agent_start, agent_end - agent_start));
+    }
+
+    if(extra != 0) {
+        entry.pid = intern_table.intern(ls_ncsa_first_field(extra));
+    }
+
+    return true;
+}
+
 //parse NCSA format access.log entry into components
 bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
 
+    //fall back to the regular expressions for lines the tokenizer can't handle
+    if(!tokenizeLine(line, entry)) {
+        return parseLineRegex(line, entry);
+    }
+
+    entry.setSuccess();
+    entry.setResponseColour();
+
+    return entry.validate();
+}
+
+bool NCSALog::parseLineRegex(std::string& line, LogEntry& entry) {
+
+    entry.reset();
+
     std::vector<std::string> matches;
     ls_ncsa_entry_start.match(line, &matches);
 
@@ -42,17 +360,15 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     }
 
     //get details
-    entry.vhost    = matches[0];
-    entry.hostname = matches[1];
+    entry.vhost    = intern_table.intern(matches[0]);
+    entry.hostname = intern_table.intern(matches[1]);
     //entry.username = matches[1];
 
     if(settings.display_log_entry) {
-        entry.log_entry = line;
+        entry.log_entry = entry.store(line);
     }
 
     //parse timestamp
-    struct tm time_str;
-
     int day, month, year, hour, minute, second;
 
     std::string request_str = matches[4];
@@ -66,30 +382,18 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     }
 
     day    = atoi(matches[0].c_str());
-    month  = atoi(matches[1].c_str());
+    month  = ls_ncsa_month(matches[1]);
     year   = atoi(matches[2].c_str());
     hour   = atoi(matches[3].c_str());
     minute = atoi(matches[4].c_str());
     second = atoi(matches[5].c_str());
 
-    if(month) {
-        month--;
-    } else {
-        //parse non numeric month
-        for(int i=0;i<12;i++) {
-            if(strcmp(matches[1].c_str(), ls_ncsa_months[i])==0) {
-                month=i;
-                break;
-            }
-        }
-    }
-
     //could not parse month (range 0-11 as used by mktime)
     if(month<0 || month>11) return 0;
 
     //convert zone to utc offset
     int tz_hour = atoi(matches[7].substr(0,2).c_str());
-    int tz_min  = atoi(matches[7].substr(2,2).c_str());
+    int tz_min  = matches[7].size() > 2 ? atoi(matches[7].substr(2,2).c_str()) : 0;
 
     int tz_offset = tz_hour * 3600 + tz_min * 60;
 
@@ -97,18 +401,7 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
         tz_offset = -tz_offset;
     }
 
-    time_str.tm_year = year - 1900;
-    time_str.tm_mon  = month;
-    time_str.tm_mday = day;
-    time_str.tm_hour = hour;
-    time_str.tm_min = minute;
-    time_str.tm_sec = second;
-    time_str.tm_isdst = -1;
-
-    entry.timestamp = mktime(&time_str);
-
-    //apply utc offset
-    entry.timestamp -= tz_offset;
+    entry.timestamp = toTimestamp(year, month, day, hour, minute, second, tz_offset);
 
     matches.clear();
     ls_ncsa_entry_request.match(request_str, &matches);
@@ -117,11 +410,11 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
         return 0;
     }
 
-    entry.method    = matches[0];
-    entry.path        = (!matches[1].empty()) ? matches[1] : "???";
-    entry.protocol  = matches[2];
+    entry.method    = entry.store(matches[0]);
+    entry.path      = intern_table.intern((!matches[1].empty()) ? matches[1] : "???");
+    entry.protocol  = entry.store(matches[2]);
 
-    entry.response_code = matches[3];
+    entry.response_code = entry.store(matches[3]);
     entry.response_size = atol(matches[4].c_str());
 
     if(matches.size() > 5) {
@@ -129,40 +422,19 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
         matches.clear();
         ls_ncsa_entry_agent.match(agentstr, &matches);
 
-        if(matches.size()==3) {
-            entry.referrer   = matches[0];
-            entry.user_agent = matches[1];
+        // NOTE: the trailing group is unset when there are no extra fields
+        if(matches.size() >= 2) {
+            entry.referrer   = entry.store(matches[0]);
+            entry.user_agent = entry.store(matches[1]);
 
-            std::string extra = matches[2];
-
-            // NOTE: could store extra fields and allow --paddle-mode to address then via their offset
-            if(!extra.empty()) {
-
-                std::vector<std::string> extra_fields;
-                if(ls_ncsa_extra_field.matchAll(extra, &extra_fields)) {
-
-//                     for(size_t i=0;i<extra_fields.size();i++) {
-//                         debugLog("extra fields %d: %s", i, extra_fields[i].c_str());
-//                     }
-
-                    if(!extra_fields.empty() && !extra_fields[0].empty()) {
-                        entry.pid = extra_fields[0];
-
-                        if(entry.pid.size()>=2 && entry.pid[0] == '"' && entry.pid[entry.pid.size()-1] == '"') {
-                            entry.pid = entry.pid.substr(1, entry.pid.size()-2);
-                        }
-                    }
-                }
+            if(matches.size() > 2) {
+                ls_ncsa_extract_pid(matches[2], entry);
             }
         }
     }
 
-    //successful if response code less than 400
-    int code = atoi(entry.response_code.c_str());
-
     entry.setSuccess();
     entry.setResponseColour();
 
     return entry.validate();
 }
-
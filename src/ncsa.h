@@ -21,10 +21,13 @@
 #include "logentry.h"
 
 class NCSALog : public AccessLog {
-
 public:
     NCSALog();
+    AccessLog* clone() const;
+    const char* getFormatName() const;
     bool parseLine(std::string& line, LogEntry& entry);
+    bool tokenizeLine(const std::string& line, LogEntry& entry);
+    bool parseLineRegex(std::string& line, LogEntry& entry);
 };
 
 #endif
@@ -16,17 +16,16 @@
 */
 
 #include "paddle.h"
-#include "requestball.h"
 #include "settings.h"
 
 #include "core/stringhash.h"
 
-Paddle::Paddle(vec2 pos, vec4 colour, std::string token, FXFont font) {
+Paddle::Paddle(vec2 pos, vec4 colour, const InternedString& token, FXFont font) {
     this->token = token;
 
 // TODO: fix colouring
 //    this->token_colour = token.size() > 0 ? colourHash2(token) : vec3(0.5,0.5,0.5);
-    this->token_colour = token.size() > 0 ? colourHash(token) : vec3(0.5,0.5,0.5);
+    this->token_colour = !token.empty() ? colourHash(token.str()) : vec3(0.5,0.5,0.5);
 
     this->pos = pos;
     this->lastcol = colour;
@@ -34,7 +33,8 @@ Paddle::Paddle(vec2 pos, vec4 colour, std::string token, FXFont font) {
     this->colour  = lastcol;
     this->width = 10;
     this->height = 50;
-    this->target = 0;
+    this->has_target = false;
+    this->ball_count = 0;
 
     font.alignTop(true);
     font.alignRight(true);
@@ -78,23 +78,39 @@ void Paddle::setX(float x) {
     pos.x = x;
 }
 
-RequestBall* Paddle::getTarget() {
-    return target;
+const InternedString& Paddle::getToken() const {
+    return token;
 }
 
-void Paddle::setTarget(RequestBall* target) {
-    this->target = target;
+bool Paddle::hasTarget() {
+    return has_target;
+}
 
-    if(target==0) {
-        moveTo(display.height/2, 4, default_colour);
-        return;
-    }
+void Paddle::clearTarget() {
+    has_target = false;
+
+    moveTo(display.height/2, 4, default_colour);
+}
+
+void Paddle::setTarget(const vec2& dest, const vec3& target_colour, float eta) {
+    has_target = true;
 
-    vec2 dest = target->getFinishPos();
     vec4 col  = (settings.paddle_mode == PADDLE_VHOST || settings.paddle_mode == PADDLE_PID)  ?
-        vec4(token_colour,1.0) : vec4(target->getColour(), 1.0f);
+        vec4(token_colour,1.0) : vec4(target_colour, 1.0f);
+
+    moveTo((int)dest.y, eta, col);
+}
+
+void Paddle::addBall() {
+    ball_count++;
+}
+
+void Paddle::removeBall() {
+    ball_count--;
+}
 
-    moveTo((int)dest.y, target->arrivalTime(), col);
+int Paddle::getBallCount() const {
+    return ball_count;
 }
 
 bool Paddle::mouseOver(TextArea& textarea, vec2& mouse) {
@@ -103,7 +119,7 @@ bool Paddle::mouseOver(TextArea& textarea, vec2& mouse) {
 
         std::vector<std::string> content;
 
-        content.push_back( token );
+        content.push_back( token.str() );
 
         textarea.setText(content);
         textarea.setPos(mouse);
@@ -124,7 +140,7 @@ void Paddle::logic(float dt) {
             //debugLog("paddle end point reached\n");
             pos.y = dest_y;
             dest_y = -1;
-            target = 0;
+            has_target = false;
             colour = nextcol;
             lastcol = colour;
         } else {
@@ -139,7 +155,7 @@ void Paddle::logic(float dt) {
 
 void Paddle::drawToken() {
     font.setColour(colour);
-    font.draw(pos.x-10, pos.y - (font.getMaxHeight()/2), token);
+    font.draw(pos.x-10, pos.y - (font.getMaxHeight()/2), token.str());
 }
 
 void Paddle::drawShadow() {
@@ -19,18 +19,21 @@
 #define PADDLE_H
 
 #include "textarea.h"
+#include "interntable.h"
 #include "core/fxfont.h"
 #include "core/vectors.h"
 
-class RequestBall;
 class Paddle {
 
 protected:
     vec2 pos;
 
-    RequestBall* target;
+    bool has_target;
 
-    std::string token;
+    // balls sent to this paddle that have not finished
+    int ball_count;
+
+    InternedString token;
     vec3 token_colour;
 
     vec4 default_colour;
@@ -48,14 +51,19 @@ protected:
 
     FXFont font;
 public:
-    Paddle(vec2 pos, vec4 colour, std::string token, FXFont font);
+    Paddle(vec2 pos, vec4 colour, const InternedString& token, FXFont font);
     ~Paddle();
     void moveTo(int y, float eta, vec4 nextcol);
     bool moving();
     bool visible();
 
-    void setTarget(RequestBall* target);
-    RequestBall* getTarget();
+    void setTarget(const vec2& dest, const vec3& target_colour, float eta);
+    void clearTarget();
+    bool hasTarget();
+
+    void addBall();
+    void removeBall();
+    int getBallCount() const;
 
     void logic(float dt);
 
@@ -67,6 +75,8 @@ public:
 
     void setX(float x);
 
+    const InternedString& getToken() const;
+
     float getX();
     float getY();
 };
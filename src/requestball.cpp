@@ -20,81 +20,201 @@
 #include "textarea.h"
 #include "logentry.h"
 
-RequestBall::RequestBall(LogEntry* le, const vec3& colour, const vec2& pos, const vec2& dest)
-    : le(le), pos(pos), dest(dest), colour(colour) {
+// RequestBallPath
 
-    dir = glm::normalize(dest - pos);
+void RequestBallPath::start(const vec2& p) {
+    points[0]      = p;
+    line_count     = 0;
+    total_distance = 0.0f;
+}
+
+void RequestBallPath::addPoint(const vec2& p) {
+    float line_length = glm::length(points[line_count] - p);
+    total_distance += line_length;
+    line_lengths[line_count] = line_length;
+    points[++line_count] = p;
+}
+
+const vec2& RequestBallPath::getFinishPos() const {
+    return points[line_count];
+}
+
+// RequestBalls
+
+RequestBalls::RequestBalls() {
+    travelled = 0.0;
+}
+
+RequestBalls::~RequestBalls() {
+    clear();
+}
+
+size_t RequestBalls::size() const {
+    return entries.size();
+}
+
+bool RequestBalls::empty() const {
+    return entries.empty();
+}
+
+void RequestBalls::add(LogEntry* le, const InternedString& paddle_token, const vec3& colour, const vec2& pos, const vec2& dest) {
 
     int bytes = le->response_size;
-    size = log((float)bytes) + 1.0f;
+    float size = log((float)bytes) + 1.0f;
     if(size<5.0f) size = 5.0f;
 
-    has_bounced = false;
-    no_bounce   = !le->successful;
+    entries.push_back(le);
+    positions.push_back(pos);
+    dests.push_back(dest);
+    dirs.push_back(glm::normalize(dest - pos));
+    colours.push_back(colour);
+    sizes.push_back(size);
+    distances.push_back(0.0f);
+
+    bounced.push_back(false);
+    no_bounce.push_back(!le->successful);
 
-    distance_travelled = 0.0f;
-    total_distance = 0.0;
+    RequestBallPath path;
+    path.start(pos);
+    path.addPoint(dest);
 
-    points.push_back(pos);
-    addPoint(dest);
+    paths.push_back(path);
 
-    float halfsize = size * 0.5f;
-    offset = vec2(halfsize, halfsize);
+    paddle_tokens.push_back(paddle_token);
+    arrivals.push_back(travelled + path.total_distance);
+
+    if(isQueued(entries.size()-1)) enqueue(entries.size()-1);
 }
 
-RequestBall::~RequestBall() {
-    delete le;
+bool RequestBalls::isQueued(size_t i) const {
+    return !bounced[i] && !no_bounce[i];
 }
 
-void RequestBall::addPoint(const vec2& p) {
-    float line_length = glm::length(points.back() - p);
-    total_distance += line_length;
-    points.push_back(p);
-    line_lengths.push_back(line_length);
+void RequestBalls::enqueue(size_t i) {
+    queues[paddle_tokens[i].getId()].insert(std::make_pair(arrivals[i], i));
 }
 
-void RequestBall::changeDestX(float dest_x) {
-    if(has_bounced) return;
+void RequestBalls::dequeue(size_t i) {
+    auto it = queues.find(paddle_tokens[i].getId());
 
-    if(dest_x <= pos.x) {
-        bounce();
-        return;
+    it->second.erase(std::make_pair(arrivals[i], i));
+
+    if(it->second.empty()) queues.erase(it);
+}
+
+bool RequestBalls::findNearest(const InternedString& paddle_token, size_t& nearest) const {
+
+    auto it = queues.find(paddle_token.getId());
+
+    if(it == queues.end()) return false;
+
+    nearest = it->second.begin()->second;
+
+    return true;
+}
+
+template<class T> static void swapRemove(std::vector<T>& v, size_t i) {
+    v[i] = v.back();
+    v.pop_back();
+}
+
+void RequestBalls::remove(size_t i) {
+    delete entries[i];
+
+    size_t last = entries.size()-1;
+
+    if(isQueued(i)) dequeue(i);
+    if(last != i && isQueued(last)) dequeue(last);
+
+    swapRemove(entries, i);
+    swapRemove(positions, i);
+    swapRemove(dests, i);
+    swapRemove(dirs, i);
+    swapRemove(colours, i);
+    swapRemove(sizes, i);
+    swapRemove(distances, i);
+    swapRemove(paths, i);
+    swapRemove(bounced, i);
+    swapRemove(no_bounce, i);
+    swapRemove(paddle_tokens, i);
+    swapRemove(arrivals, i);
+
+    if(last != i && isQueued(i)) enqueue(i);
+}
+
+void RequestBalls::clear() {
+    for(LogEntry* le : entries) {
+        delete le;
     }
 
-    float t = (dir.y / dir.x);
+    entries.clear();
+    positions.clear();
+    dests.clear();
+    dirs.clear();
+    colours.clear();
+    sizes.clear();
+    distances.clear();
+    paths.clear();
+    bounced.clear();
+    no_bounce.clear();
+    paddle_tokens.clear();
+    arrivals.clear();
+
+    queues.clear();
+}
 
-    vec2 start = points[0];
+void RequestBalls::changeDestX(float dest_x) {
 
-    float a = t * (dest_x - start.x);
-    float y = start.y + a;
+    for(size_t i=0; i<entries.size(); i++) {
+        if(bounced[i]) continue;
 
-    dest = vec2(dest_x, y);
+        if(dest_x <= positions[i].x) {
+            bounce(i);
+            continue;
+        }
 
-    total_distance = 0.0f;
-    line_lengths.clear();
+        float t = (dirs[i].y / dirs[i].x);
+
+        RequestBallPath& path = paths[i];
+
+        vec2 start = path.points[0];
+
+        float a = t * (dest_x - start.x);
+        float y = start.y + a;
+
+        dests[i] = vec2(dest_x, y);
+
+        if(isQueued(i)) dequeue(i);
+
+        path.start(start);
+        path.addPoint(dests[i]);
 
-    points.clear();
-    points.push_back(start);
-    addPoint(dest);
+        arrivals[i] = travelled - distances[i] + path.total_distance;
+
+        if(isQueued(i)) enqueue(i);
+    }
 }
 
-void RequestBall::project() {
-    distance_travelled = 0.0f;
-    total_distance     = 0.0f;
+void RequestBalls::project(size_t i) {
+    distances[i] = 0.0f;
+
+    const vec2& pos = positions[i];
+    vec2& dir       = dirs[i];
 
-    vec2 target = dest;
+    vec2 target = dests[i];
 
-    if(!no_bounce) {
+    if(!no_bounce[i]) {
         dir.x  = -dir.x;
         target.x = 0;
     } else {
         target.x = display.width;
     }
 
-    points.clear();
-    line_lengths.clear();
+    float halfsize = sizes[i] * 0.5f;
 
-    points.push_back(pos);
+    RequestBallPath& path = paths[i];
+
+    path.start(pos);
 
     // tan = o / a
     // o = tan * a
@@ -105,18 +225,18 @@ void RequestBall::project() {
     float a = (target.x - pos.x);
     float y = pos.y + t * a;
 
-    if(y < offset.y || y > display.height-offset.y) {
+    if(y < halfsize || y > display.height-halfsize) {
 
         // bounced off the top/bottom of screen
 
-        float intersect_y = y <= offset.y ? offset.y : display.height-offset.y;
+        float intersect_y = y <= halfsize ? halfsize : display.height-halfsize;
 
         float o = (intersect_y - pos.y);
         float x = pos.x + (o / t);
 
         vec2 intersect = vec2(x, intersect_y);
 
-        addPoint(intersect);
+        path.addPoint(intersect);
 
         // continue from bounce to destination
 
@@ -131,50 +251,56 @@ void RequestBall::project() {
 
         intersect = vec2(target.x, y);
 
-        addPoint(intersect);
+        path.addPoint(intersect);
     } else {
         vec2 intersect = vec2(target.x, y);
-        addPoint(intersect);
+        path.addPoint(intersect);
     }
 }
 
-bool RequestBall::isFinished() const {
-    return has_bounced && distance_travelled >= total_distance;
+bool RequestBalls::isFinished(size_t i) const {
+    return bounced[i] && distances[i] >= paths[i].total_distance;
 }
 
-void RequestBall::bounce() {
-    if(has_bounced) return;
+void RequestBalls::bounce(size_t i) {
+    if(bounced[i]) return;
+
+    if(isQueued(i)) dequeue(i);
+
+    project(i);
 
-    project();
+    bounced[i] = true;
+}
 
-    has_bounced=true;
+float RequestBalls::arrivalTime(size_t i) const {
+    return (paths[i].total_distance-distances[i]) / (settings.pitch_speed * (float) display.width);
 }
 
-float RequestBall::arrivalTime() {
-    return (total_distance-distance_travelled) / (settings.pitch_speed * (float) display.width);
+float RequestBalls::getProgress(size_t i) const {
+    return (distances[i]/paths[i].total_distance);
 }
 
-float RequestBall::getProgress() const {
-    return (distance_travelled/total_distance);
+const vec2& RequestBalls::getFinishPos(size_t i) const {
+    return paths[i].getFinishPos();
 }
 
-const vec2& RequestBall::getFinishPos() const {
-    return points.back();
+bool RequestBalls::hasBounced(size_t i) const {
+    return bounced[i];
 }
 
-bool RequestBall::hasBounced() const {
-    return has_bounced;
+const vec3& RequestBalls::getColour(size_t i) const {
+    return colours[i];
 }
 
-const vec3& RequestBall::getColour() const {
-    return colour;
+LogEntry* RequestBalls::getLogEntry(size_t i) const {
+    return entries[i];
 }
 
-LogEntry* RequestBall::getLogEntry() const {
-    return le;
+const InternedString& RequestBalls::getPaddleToken(size_t i) const {
+    return paddle_tokens[i];
 }
 
-void RequestBall::formatRequestDetail(LogEntry* le, TextArea& textarea) {
+void RequestBalls::formatRequestDetail(LogEntry* le, TextArea& textarea) {
 
     std::vector<std::string> content;
 
@@ -217,109 +343,139 @@ void RequestBall::formatRequestDetail(LogEntry* le, TextArea& textarea) {
     textarea.setText(content);
 }
 
-bool RequestBall::mouseOver(TextArea& textarea, vec2& mouse) {
+bool RequestBalls::mouseOver(TextArea& textarea, vec2& mouse) {
+
+    for(size_t i=0; i<entries.size(); i++) {
 
-    //within 3 pixels
-    vec2 from_mouse = pos - mouse;
+        //within 3 pixels
+        vec2 from_mouse = positions[i] - mouse;
 
-    if( glm::dot(from_mouse, from_mouse) < 36.0f) {
+        if( glm::dot(from_mouse, from_mouse) < 36.0f) {
 
-        std::vector<std::string> content;
-        formatRequestDetail(le, textarea);
+            formatRequestDetail(entries[i], textarea);
 
-        textarea.setPos(mouse);
-        textarea.setColour(colour);
-        return true;
+            textarea.setPos(mouse);
+            textarea.setColour(colours[i]);
+            return true;
+        }
     }
 
     return false;
 }
 
-void RequestBall::animate(float dt) {
-    distance_travelled += dt * settings.pitch_speed * (float) display.width;
+void RequestBalls::animate(size_t i, float distance) {
+    float& distance_travelled = distances[i];
+
+    distance_travelled += distance;
 
-    if(distance_travelled >= total_distance) {
+    const RequestBallPath& path = paths[i];
 
-        if(!has_bounced) {
-            bounce();
+    if(distance_travelled >= path.total_distance) {
+
+        if(!bounced[i]) {
+            bounce(i);
         }
         return;
     }
 
-    //number of lines
-    int nolines = points.size()-1;
-
     int pointno = 0;
     float len=0;
 
-    while(pointno < nolines && len+line_lengths[pointno] < distance_travelled) {
-        len += line_lengths[pointno];
+    while(pointno < path.line_count && len+path.line_lengths[pointno] < distance_travelled) {
+        len += path.line_lengths[pointno];
         pointno++;
     }
 
-    if(pointno>=nolines) {
+    if(pointno>=path.line_count) {
 
-        if(!has_bounced) {
-            bounce();
-            return;
+        if(!bounced[i]) {
+            bounce(i);
         }
 
         return;
     }
 
-    vec2 from = points[pointno];
-    vec2 to   = points[pointno+1];
+    const vec2& from = path.points[pointno];
+    const vec2& to   = path.points[pointno+1];
 
-    float linepos = (distance_travelled - len)/line_lengths[pointno];
+    float linepos = (distance_travelled - len)/path.line_lengths[pointno];
 
-    this->pos = from + ((to-from)*linepos);
+    positions[i] = from + ((to-from)*linepos);
 }
 
-int RequestBall::logic(float dt) {
-    float old_x = pos.x;
+int RequestBalls::logic(float dt) {
+
+    float distance = dt * settings.pitch_speed * (float) display.width;
 
-    animate(dt);
+    travelled += distance;
 
-    //returns 1 if just became visible (for score incrementing)
-    return (old_x<0.0f && pos.x>=0.0f);
+    int visible = 0;
+
+    for(size_t i=0; i<entries.size(); i++) {
+        float old_x = positions[i].x;
+
+        animate(i, distance);
+
+        if(old_x<0.0f && positions[i].x>=0.0f) visible++;
+    }
+
+    return visible;
 }
 
-void RequestBall::drawGlow() const {
-    if(!has_bounced) return;
+bool RequestBalls::isVisible(size_t i) const {
+    return !settings.no_bounce || !bounced[i] || no_bounce[i];
+}
 
-    float prog = getProgress();
+float RequestBalls::getGlowAlpha(size_t i) const {
+    if(!bounced[i]) return 0.0f;
 
-    float glow_radius = size * size * settings.glow_multiplier;
+    float prog = getProgress(i);
 
-    float alpha = std::min(1.0f, 1.0f-(prog/settings.glow_duration)) * settings.glow_intensity;
+    return std::min(1.0f, 1.0f-(prog/settings.glow_duration)) * settings.glow_intensity;
+}
 
-    if(alpha <=0.001f) return;
-    
-    vec3 glow_col = colour * alpha;
+void RequestBalls::drawGlow() const {
 
-    glColor4f(glow_col.x, glow_col.y, glow_col.z, 1.0f);
+    for(size_t i=0; i<entries.size(); i++) {
 
-    glPushMatrix();
-        glTranslatef(pos.x, pos.y, 0.0f);
+        float alpha = getGlowAlpha(i);
 
-        glBegin(GL_QUADS);
-            glTexCoord2f(1.0f, 1.0f);
-            glVertex2f(glow_radius,glow_radius);
-            glTexCoord2f(1.0f, 0.0f);
-            glVertex2f(glow_radius,-glow_radius);
-            glTexCoord2f(0.0f, 0.0f);
-            glVertex2f(-glow_radius,-glow_radius);
-            glTexCoord2f(0.0f, 1.0f);
-            glVertex2f(-glow_radius,glow_radius);
-        glEnd();
-    glPopMatrix();
+        if(alpha <=0.001f) continue;
+
+        float glow_radius = sizes[i] * sizes[i] * settings.glow_multiplier;
+
+        vec3 glow_col = colours[i] * alpha;
+
+        glColor4f(glow_col.x, glow_col.y, glow_col.z, 1.0f);
+
+        glPushMatrix();
+            glTranslatef(positions[i].x, positions[i].y, 0.0f);
+
+            glBegin(GL_QUADS);
+                glTexCoord2f(1.0f, 1.0f);
+                glVertex2f(glow_radius,glow_radius);
+                glTexCoord2f(1.0f, 0.0f);
+                glVertex2f(glow_radius,-glow_radius);
+                glTexCoord2f(0.0f, 0.0f);
+                glVertex2f(-glow_radius,-glow_radius);
+                glTexCoord2f(0.0f, 1.0f);
+                glVertex2f(-glow_radius,glow_radius);
+            glEnd();
+        glPopMatrix();
+    }
 }
 
-void RequestBall::draw() const {
+void RequestBalls::draw() const {
+
+    for(size_t i=0; i<entries.size(); i++) {
+
+        if(!isVisible(i)) continue;
+
+        float size = sizes[i];
 
-    if(!settings.no_bounce || !has_bounced || no_bounce) {
+        vec2 offsetpos = positions[i] - vec2(size * 0.5f, size * 0.5f);
 
-        vec2 offsetpos = pos - offset;
+        const vec3& colour = colours[i];
 
         glColor4f(colour.x, colour.y, colour.z, 1.0f);
 
@@ -343,17 +499,62 @@ void RequestBall::draw() const {
     }
 }
 
-void RequestBall::drawResponseCode(FXFont* font) const {
-    float prog = getProgress();
+void RequestBalls::updateVBO(quadbuf& buffer, GLuint textureid) const {
 
-    float alpha = 1.0f - std::min(1.0f, prog * 2.0f);
+    buffer.reset();
 
-    if(alpha<=0.001f) return;
-    
-    float drift = prog * 100.0f;
+    for(size_t i=0; i<entries.size(); i++) {
 
-    vec2 msgpos = (dir * drift) + vec2(dest.x-45.0f, dest.y);
-    
-    font->setColour(vec4(le->response_colour.x, le->response_colour.y, le->response_colour.z, alpha));
-    font->draw(msgpos.x, msgpos.y, le->response_code);
+        if(!isVisible(i)) continue;
+
+        float size = sizes[i];
+
+        vec2 offsetpos = positions[i] - vec2(size * 0.5f, size * 0.5f);
+
+        buffer.add(textureid, offsetpos, vec2(size, size), vec4(colours[i], 1.0f));
+    }
+
+    buffer.update();
+}
+
+void RequestBalls::updateGlowVBO(quadbuf& buffer, GLuint textureid) const {
+
+    buffer.reset();
+
+    for(size_t i=0; i<entries.size(); i++) {
+
+        float alpha = getGlowAlpha(i);
+
+        if(alpha <=0.001f) continue;
+
+        float glow_radius = sizes[i] * sizes[i] * settings.glow_multiplier;
+
+        vec3 glow_col = colours[i] * alpha;
+
+        buffer.add(textureid, positions[i] - vec2(glow_radius, glow_radius), vec2(glow_radius * 2.0f, glow_radius * 2.0f), vec4(glow_col, 1.0f));
+    }
+
+    buffer.update();
+}
+
+void RequestBalls::drawResponseCodes(FXFont* font) const {
+
+    for(size_t i=0; i<entries.size(); i++) {
+        if(!bounced[i]) continue;
+
+        float prog = getProgress(i);
+
+        float alpha = 1.0f - std::min(1.0f, prog * 2.0f);
+
+        if(alpha<=0.001f) continue;
+
+        float drift = prog * 100.0f;
+
+        vec2 msgpos = (dirs[i] * drift) + vec2(dests[i].x-45.0f, dests[i].y);
+
+        LogEntry* le = entries[i];
+
+        font->setColour(vec4(le->response_colour.x, le->response_colour.y, le->response_colour.z, alpha));
+        font->draw(msgpos.x, msgpos.y, le->response_code.to_string());
+    }
 }
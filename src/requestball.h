@@ -20,69 +20,126 @@
 
 #include <vector>
 #include <string>
+#include <set>
+#include <unordered_map>
+
+#include "interntable.h"
 
 #include "core/vectors.h"
+#include "core/vbo.h"
+
+#define REQUEST_BALL_MAX_LINES 2
 
 class FXFont;
 class TextArea;
 class LogEntry;
 
-class RequestBall {
+// path of a ball: the line to the paddle, or after bouncing
+// the line away from it, split in two if it bounces off the edge of the screen
+
+class RequestBallPath {
+public:
+    vec2  points[REQUEST_BALL_MAX_LINES+1];
+    float line_lengths[REQUEST_BALL_MAX_LINES];
+    int   line_count;
+
+    float total_distance;
+
+    void start(const vec2& p);
+    void addPoint(const vec2& p);
+
+    const vec2& getFinishPos() const;
+};
+
+// balls heading to a paddle, ordered by the distance moved by all balls when each will arrive
+typedef std::set< std::pair<double, size_t> > RequestBallQueue;
+
+// request balls stored as parallel arrays so each pass over them only reads the fields it uses.
+// a ball is identified by its index. removing a ball moves the last ball into its place
+
+class RequestBalls {
 protected:
-    std::vector<vec2> points;
-    std::vector<float> line_lengths;
+    std::vector<LogEntry*> entries;
 
-    LogEntry* le;
+    std::vector<vec2>  positions;
+    std::vector<vec2>  dests;
+    std::vector<vec2>  dirs;
+    std::vector<vec3>  colours;
+    std::vector<float> sizes;
+    std::vector<float> distances;
 
-    float size;
+    std::vector<RequestBallPath> paths;
 
-    vec2 pos;
-    vec2 dest;
-    vec2 dir;
+    // token of the paddle each ball is heading to, and the value of travelled when it arrives
+    std::vector<InternedString> paddle_tokens;
+    std::vector<double> arrivals;
 
-    vec3 colour;
+    // distance moved by every ball so far
+    double travelled;
 
-    float distance_travelled;
-    float total_distance;
+    // successful balls yet to bounce by paddle token id
+    std::unordered_map<int, RequestBallQueue> queues;
 
-    bool has_bounced;
-    bool no_bounce;
+    // char rather than bool to avoid the std::vector<bool> specialization
+    std::vector<char> bounced;
+    std::vector<char> no_bounce;
 
-    vec2 offset;
+    static void formatRequestDetail(LogEntry *le, TextArea& textarea);
 
-    void formatRequestDetail(LogEntry *le, TextArea& textarea);
+    float getProgress(size_t i) const;
 
-    float getProgress() const;
+    bool isVisible(size_t i) const;
+    float getGlowAlpha(size_t i) const;
 
-    void project();
-    void bounce();
+    bool isQueued(size_t i) const;
+    void enqueue(size_t i);
+    void dequeue(size_t i);
 
-    void addPoint(const vec2& p);
+    void project(size_t i);
+    void bounce(size_t i);
 
-    void animate(float dt);
+    void animate(size_t i, float distance);
 public:
-    RequestBall(LogEntry* le, const vec3& colour, const vec2& pos, const vec2& dest);
-    ~RequestBall();
+    RequestBalls();
+    ~RequestBalls();
 
-    bool mouseOver(TextArea& textarea, vec2& mouse);
+    size_t size() const;
+    bool empty() const;
 
-    float arrivalTime();
+    void add(LogEntry* le, const InternedString& paddle_token, const vec3& colour, const vec2& pos, const vec2& dest);
 
-    bool isFinished() const;
-    bool hasBounced() const;
+    // delete the ball and its log entry
+    void remove(size_t i);
+    void clear();
 
-    void changeDestX(float dest_x);
+    LogEntry* getLogEntry(size_t i) const;
+    const InternedString& getPaddleToken(size_t i) const;
 
-    const vec2& getFinishPos() const;
+    float arrivalTime(size_t i) const;
+
+    // the successful ball that will reach the paddle with this token first
+    bool findNearest(const InternedString& paddle_token, size_t& nearest) const;
 
-    const vec3& getColour() const;
-    LogEntry* getLogEntry() const;
+    bool isFinished(size_t i) const;
+    bool hasBounced(size_t i) const;
 
+    const vec2& getFinishPos(size_t i) const;
+    const vec3& getColour(size_t i) const;
+
+    void changeDestX(float dest_x);
+
+    bool mouseOver(TextArea& textarea, vec2& mouse);
+
+    // returns the number of balls that just became visible (for score incrementing)
     int logic(float dt);
 
     void drawGlow() const;
     void draw() const;
-    void drawResponseCode(FXFont* font) const;
+    void drawResponseCodes(FXFont* font) const;
+
+    // fill buffers with a quad per ball or glow, to draw all of them at once
+    void updateVBO(quadbuf& buffer, GLuint textureid) const;
+    void updateGlowVBO(quadbuf& buffer, GLuint textureid) const;
 };
 
 #endif
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "requestwindow.h"
+
+#include <algorithm>
+
+// RequestWindowEntry
+
+RequestWindowEntry::RequestWindowEntry(Summarizer* group, const InternedString& path, const InternedString& hostname)
+    : group(group), path(path), hostname(hostname), count(1), in_group(true), in_hosts(true) {
+}
+
+size_t RequestWindowHash::operator()(const std::pair<Summarizer*, uint64_t>& key) const {
+    return std::hash<Summarizer*>()(key.first) ^ std::hash<uint64_t>()(key.second * 0x9E3779B97F4A7C15ULL);
+}
+
+// RequestWindowBucket
+
+void RequestWindowBucket::add(Summarizer* group, const InternedString& path, const InternedString& hostname) {
+
+    std::pair<Summarizer*, uint64_t> key(group, ((uint64_t) (uint32_t) path.getId() << 32) | (uint32_t) hostname.getId());
+
+    auto it = index.find(key);
+
+    // an entry left out of a summarizer by a refilter starts over
+    if(it != index.end() && entries[it->second].in_group && entries[it->second].in_hosts) {
+        entries[it->second].count++;
+        return;
+    }
+
+    index[key] = entries.size();
+    entries.push_back(RequestWindowEntry(group, path, hostname));
+}
+
+void RequestWindowBucket::clear() {
+    entries.clear();
+    index.clear();
+}
+
+// RequestWindow
+
+RequestWindow::RequestWindow(int seconds) : head(0), head_time(0) {
+    buckets.resize(std::max(1, seconds));
+}
+
+int RequestWindow::getSeconds() const {
+    return buckets.size();
+}
+
+void RequestWindow::add(Summarizer* group, const InternedString& path, const InternedString& hostname) {
+    buckets[head].add(group, path, hostname);
+}
+
+void RequestWindow::advance(time_t time, std::vector<RequestWindowEntry>& expired) {
+
+    if(head_time == 0) head_time = time;
+
+    if(time <= head_time) return;
+
+    // expire at most every bucket once
+    time_t steps = std::min(time - head_time, (time_t) buckets.size());
+
+    for(time_t i=0; i<steps; i++) {
+        head = (head + 1) % buckets.size();
+
+        RequestWindowBucket& bucket = buckets[head];
+
+        expired.insert(expired.end(), bucket.entries.begin(), bucket.entries.end());
+        bucket.clear();
+    }
+
+    head_time = time;
+}
+
+void RequestWindow::getEntries(std::vector<RequestWindowEntry*>& entries) {
+
+    for(RequestWindowBucket& bucket : buckets) {
+        for(RequestWindowEntry& entry : bucket.entries) {
+            entries.push_back(&entry);
+        }
+    }
+}
+
+void RequestWindow::clear() {
+
+    for(RequestWindowBucket& bucket : buckets) {
+        bucket.clear();
+    }
+
+    head = 0;
+    head_time = 0;
+}
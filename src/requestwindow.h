@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REQUEST_WINDOW_H
+#define REQUEST_WINDOW_H
+
+#include "summarizer.h"
+#include "interntable.h"
+
+#include <stdint.h>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+
+// count of requests with the same group, path and hostname.
+// records which summarizers the requests are counted in, as prefix filters
+// set after they were added can leave them out of either
+
+class RequestWindowEntry {
+public:
+    RequestWindowEntry(Summarizer* group, const InternedString& path, const InternedString& hostname);
+
+    Summarizer* group;
+    InternedString path;
+    InternedString hostname;
+    int count;
+
+    bool in_group;
+    bool in_hosts;
+};
+
+class RequestWindowHash {
+public:
+    size_t operator()(const std::pair<Summarizer*, uint64_t>& key) const;
+};
+
+// requests summarized during one second
+
+class RequestWindowBucket {
+    std::unordered_map<std::pair<Summarizer*, uint64_t>, size_t, RequestWindowHash> index;
+public:
+    std::vector<RequestWindowEntry> entries;
+
+    void add(Summarizer* group, const InternedString& path, const InternedString& hostname);
+    void clear();
+};
+
+// requests of the last number of seconds in a ring buffer of per second buckets.
+// when the window moves on, the requests of the seconds that left it expire together
+
+class RequestWindow {
+    std::vector<RequestWindowBucket> buckets;
+
+    size_t head;
+    time_t head_time;
+public:
+    RequestWindow(int seconds);
+
+    int getSeconds() const;
+
+    // add a request counted in its group and the hostname summarizer to the current second
+    void add(Summarizer* group, const InternedString& path, const InternedString& hostname);
+
+    // move the window to end at a time, appending requests of the seconds that left it to expired
+    void advance(time_t time, std::vector<RequestWindowEntry>& expired);
+
+    void getEntries(std::vector<RequestWindowEntry*>& entries);
+
+    void clear();
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+
+template <class T> class RingQueue {
+    std::vector<T> items;
+
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    size_t next(size_t index) const {
+        return (index + 1) % items.size();
+    }
+public:
+    RingQueue(size_t capacity) : items(capacity + 1), head(0), tail(0) {
+    }
+
+    // producer: returns false if the queue is full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t n = next(t);
+
+        if(n == head.load(std::memory_order_acquire)) return false;
+
+        items[t] = item;
+        tail.store(n, std::memory_order_release);
+
+        return true;
+    }
+
+    bool full() const {
+        return next(tail.load(std::memory_order_relaxed)) == head.load(std::memory_order_acquire);
+    }
+
+    // consumer: returns false if the queue is empty
+    bool front(T& item) const {
+        size_t h = head.load(std::memory_order_relaxed);
+
+        if(h == tail.load(std::memory_order_acquire)) return false;
+
+        item = items[h];
+
+        return true;
+    }
+
+    void pop() {
+        size_t h = head.load(std::memory_order_relaxed);
+        head.store(next(h), std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif
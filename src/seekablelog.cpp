@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "seekablelog.h"
+#include "compressedlog.h"
+#include "mappedlog.h"
+
+#include "core/logger.h"
+
+SeekableLog* SeekableLog::open(const std::string& path) {
+
+    SeekableLog* log = CompressedLog::open(path);
+
+    if(log != 0) return log;
+
+    log = MappedLog::open(path);
+
+    if(log != 0) return log;
+
+    //pipes and files that cannot be mapped
+    debugLog("reading %s through a stream", path.c_str());
+
+    return new StreamSeekLog(path);
+}
+
+//StreamSeekLog
+
+StreamSeekLog::StreamSeekLog(const std::string& path) : seeklog(path) {
+}
+
+float StreamSeekLog::getPercent() {
+    return seeklog.getPercent();
+}
+
+void StreamSeekLog::seekTo(float percent) {
+    seeklog.seekTo(percent);
+}
+
+bool StreamSeekLog::getNextLineAt(std::string& line, float percent) {
+    return seeklog.getNextLineAt(line, percent);
+}
+
+//SeekLog peeks by seeking its stream and seeking back
+bool StreamSeekLog::peekSharesReader() {
+    return true;
+}
+
+bool StreamSeekLog::getNextLine(std::string& line) {
+    return seeklog.getNextLine(line);
+}
+
+bool StreamSeekLog::isFinished() {
+    return seeklog.isFinished();
+}
@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEEKABLE_LOG_H
+#define SEEKABLE_LOG_H
+
+#include "core/seeklog.h"
+
+#include <string>
+
+// log file that can be read from a position given as a fraction of its size
+
+class SeekableLog : public BaseLog {
+public:
+    virtual ~SeekableLog() {};
+
+    virtual float getPercent() = 0;
+    virtual void seekTo(float percent) = 0;
+
+    // read the first complete line at a position without changing the read position
+    virtual bool getNextLineAt(std::string& line, float percent) = 0;
+
+    // true if getNextLineAt uses the same reader as getNextLine, so the two
+    // can't be called at the same time from different threads
+    virtual bool peekSharesReader() { return false; }
+
+    // decompress the file if it is compressed, memory map it if possible,
+    // otherwise read it through a stream.
+    // throws SeekLogException if the file cannot be read
+    static SeekableLog* open(const std::string& path);
+};
+
+// file read through a SeekLog stream
+
+class StreamSeekLog : public SeekableLog {
+    SeekLog seeklog;
+public:
+    StreamSeekLog(const std::string& path);
+
+    float getPercent();
+    void seekTo(float percent);
+
+    bool getNextLineAt(std::string& line, float percent);
+    bool peekSharesReader();
+    bool getNextLine(std::string& line);
+    bool isFinished();
+};
+
+#endif
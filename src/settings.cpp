@@ -21,6 +21,8 @@
 #include "core/sdlapp.h"
 #include "core/seeklog.h"
 #include "logentry.h"
+#include "accesslogregistry.h"
+#include "jsonlog.h"
 
 #include <time.h>
 #include <algorithm>
@@ -55,7 +57,9 @@ void LogstalgiaSettings::help(bool extended_help) {
     printf("  -x --full-hostnames        Show full request ip/hostname\n");
     printf("  -s --simulation-speed      Simulation speed (default: 1)\n");
     printf("  -p --pitch-speed           Speed balls travel across screen (default: 0.15)\n");
-    printf("  -u --update-rate           Page summary update rate (default: 5)\n\n");
+    printf("  -u --update-rate           Page summary update rate (default: 5)\n");
+    printf("  --summary-window SECONDS   Summarize requests of the last SECONDS seconds\n");
+    printf("                             instead of requests in flight\n\n");
 
     printf("  -g name,(HOST|URI|CODE)=regex[,SEP=chars][,MAX=n][,ABBR=n],percent[,colour]\n");
     printf("                             Group together requests where the HOST, URI\n");
@@ -72,6 +76,9 @@ void LogstalgiaSettings::help(bool extended_help) {
     printf("  --paddle-mode MODE         Paddle mode (single, pid, vhost)\n");
     printf("  --paddle-position POSITION Paddle position as a fraction of the view width\n\n");
 
+    printf("  --log-format FORMAT        Log format (ncsa, custom, json). Detected by default\n");
+    printf("  --json-fields FIELD=KEY    Comma separated list of JSON keys to read fields from\n\n");
+
     printf("  --display-fields FIELDS    Comma separated list of fields shown on hover:\n");
     printf("                             timestamp,hostname,path,method,protocol\n");
     printf("                             response_size,response_code,referrer\n");
@@ -127,6 +134,7 @@ LogstalgiaSettings::LogstalgiaSettings() {
     log_level = LOG_LEVEL_OFF;
     splash    = -1.0f;
     run_tests = false;
+    run_benchmarks = false;
 
     setLogstalgiaDefaults();
 
@@ -149,6 +157,7 @@ LogstalgiaSettings::LogstalgiaSettings() {
     //command line only options
     conf_sections["help"]            = "command-line";
     conf_sections["test"]            = "command-line";
+    conf_sections["benchmark"]       = "command-line";
     conf_sections["extended-help"]   = "command-line";
     conf_sections["load-config"]     = "command-line";
     conf_sections["save-config"]     = "command-line";
@@ -162,9 +171,11 @@ LogstalgiaSettings::LogstalgiaSettings() {
     arg_types["address-abbr-depth"] = "int";
     arg_types["path-max-depth"]     = "int";
     arg_types["path-abbr-depth"]    = "int";
+    arg_types["summary-window"]     = "int";
 
     arg_types["help"]          = "bool";
     arg_types["test"]          = "bool";
+    arg_types["benchmark"]     = "bool";
     arg_types["extended-help"] = "bool";
     arg_types["splash"]        = "bool";
 
@@ -205,6 +216,8 @@ LogstalgiaSettings::LogstalgiaSettings() {
     arg_types["stop-position"]      = "string";
     arg_types["paddle-mode"]        = "string";
     arg_types["display-fields"]     = "string";
+    arg_types["log-format"]         = "string";
+    arg_types["json-fields"]        = "string";
     arg_types["address-separators"] = "string";
     arg_types["group-separators"]   = "string";
 
@@ -214,6 +227,8 @@ LogstalgiaSettings::LogstalgiaSettings() {
 void LogstalgiaSettings::setLogstalgiaDefaults() {
 
     path = "";
+    log_format = "";
+    json_fields.clear();
     display_fields.clear();
     display_log_entry = false;
 
@@ -241,6 +256,8 @@ void LogstalgiaSettings::setLogstalgiaDefaults() {
     simulation_speed  = 1.0f;
     update_rate       = 5.0f;
 
+    summary_window = 0;
+
     glow_intensity  = 0.5f;
     glow_multiplier = 1.25f;
     glow_duration   = 0.15f;
@@ -280,6 +297,11 @@ void LogstalgiaSettings::commandLineOption(const std::string& name, const std::s
         return;
     }
 
+    if(name == "benchmark") {
+        run_benchmarks = true;
+        return;
+    }
+
     if(name == "extended-help") {
         help(true);
     }
@@ -581,6 +603,17 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
         }
     }
 
+    if((entry = settings->getEntry("summary-window")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify summary window in seconds (0 to 86400)");
+
+        summary_window = entry->getInt();
+
+        if(summary_window < 0 || summary_window > 86400) {
+            conffile.entryException(entry, "summary window should be between 0 and 86400 seconds");
+        }
+    }
+
     if(settings->getBool("sync")) {
         sync = true;
     }
@@ -672,6 +705,49 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
         }
     }
 
+    if((entry = settings->getEntry("log-format")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify log-format (ncsa,custom,json)");
+
+        log_format = entry->getString();
+
+        if(!AccessLogRegistry::hasFormat(log_format)) {
+            conffile.entryException(entry, "invalid log-format");
+        }
+    }
+
+    if((entry = settings->getEntry("json-fields")) != 0) {
+        json_fields.clear();
+
+        if(!entry->hasValue()) conffile.missingValueException(entry);
+
+        std::string field_list = entry->getString();
+
+        boost::algorithm::erase_all(field_list, " ");
+
+        std::vector<std::string> mappings;
+        boost::algorithm::split(mappings, field_list, boost::algorithm::is_any_of(","), boost::algorithm::token_compress_on);
+
+        for(const std::string& mapping : mappings) {
+            if(mapping.empty()) continue;
+
+            size_t sep = mapping.find("=");
+
+            if(sep == std::string::npos || sep == 0 || sep == mapping.size()-1) {
+                conffile.entryException(entry, std::string("invalid json field mapping ") + mapping);
+            }
+
+            std::string field = mapping.substr(0, sep);
+            std::string key   = mapping.substr(sep+1);
+
+            if(JSONLog::getFieldByName(field) == -1) {
+                conffile.entryException(entry, std::string("invalid json field ") + field);
+            }
+
+            json_fields.push_back(std::make_pair(field, key));
+        }
+    }
+
     //validate path
     if(settings->hasValue("path")) {
         path = settings->getString("path");
@@ -756,6 +832,22 @@ void LogstalgiaSettings::exportLogstalgiaSettings(ConfFile& conf) {
         settings->addEntry(new ConfEntry("display-fields", display_fields_string));
     }
 
+    if(!log_format.empty()) {
+        settings->addEntry(new ConfEntry("log-format", log_format));
+    }
+
+    if(!json_fields.empty()) {
+
+        std::string json_fields_string;
+
+        for(auto& mapping : json_fields) {
+            if(!json_fields_string.empty()) json_fields_string += ",";
+            json_fields_string += mapping.first + "=" + mapping.second;
+        }
+
+        settings->addEntry(new ConfEntry("json-fields", json_fields_string));
+    }
+
     if(background_colour != vec3(0.0f)) {
         char background_hex[256];
         vec3 bg = background_colour * 255.0f;
@@ -822,6 +914,10 @@ void LogstalgiaSettings::exportLogstalgiaSettings(ConfFile& conf) {
         settings->addEntry(new ConfEntry("update-rate", update_rate));
     }
 
+    if(summary_window != 0) {
+        settings->addEntry(new ConfEntry("summary-window", summary_window));
+    }
+
     if(sync) {
         settings->addEntry(new ConfEntry("sync", sync));
     }
@@ -55,6 +55,9 @@ public:
     std::string path;
     std::vector<SummarizerGroup> groups;
 
+    std::string log_format;
+    std::vector<std::pair<std::string, std::string> > json_fields;
+
     std::string load_config;
     std::string save_config;
 
@@ -63,6 +66,7 @@ public:
 
     bool detect_changes;
     bool run_tests;
+    bool run_benchmarks;
 
     time_t start_time;
     time_t stop_time;
@@ -73,6 +77,9 @@ public:
     float pitch_speed;
     float update_rate;
 
+    // seconds of requests summarized, 0 for the requests in flight
+    int   summary_window;
+
     int   paddle_mode;
     float paddle_position;
 
@@ -48,27 +48,33 @@ if has children:
 SummRow::SummRow() {
     this->words=0;
     this->refs=0;
+    this->expanded_count=0;
 }
 
-SummRow::SummRow(SummNode* source, bool abbreviated) {
+SummRow::SummRow(const SummChar& source, bool abbreviated) {
     this->source    = source;
-    this->words     = source->words; // TODO: just reference source ??
-    this->refs      = source->refs;
+    this->words     = source.getWords(); // TODO: just reference source ??
+    this->refs      = source.getRefs();
     this->abbreviated = abbreviated;
+    this->expanded_count = 0;
 
     // should this happen here?
-    if(source->parent!=0) prependChar(source->c);
+    if(!source.isRoot()) prependChar(source.c());
 }
 
-void SummRow::buildSummary() {
-    expanded.clear();
-    source->expand(str, expanded, abbreviated);
+void SummRow::countExpanded() {
+    expanded_children.clear();
+    expanded_count = source.countExpansion(abbreviated, expanded_children);
 }
 
 void SummRow::prependChar(char c) {
     str.insert(0,1,c);
 }
 
+void SummRow::prepend(const char* str, size_t length) {
+    this->str.insert(0, str, length);
+}
+
 //SummQuery
 
 SummQuery::SummQuery(int max_depth, int abbreviation_depth)
@@ -91,124 +97,247 @@ int SummQuery::getAbbreviationDepth() const {
     return abbreviation_depth;
 }
 
+bool SummQuery::operator==(const SummQuery& other) const {
+    return max_depth == other.max_depth && abbreviation_depth == other.abbreviation_depth;
+}
+
+//SummCacheEntry
+
+SummCacheEntry::SummCacheEntry(const SummQuery& query, int max_rows, int depth)
+    : query(query), max_rows(max_rows), depth(depth) {
+}
+
+bool SummCacheEntry::matches(const SummQuery& query, int max_rows, int depth) const {
+    return this->max_rows == max_rows && this->depth == depth && this->query == query;
+}
+
+void SummCacheEntry::replayFlags(std::vector<std::pair<SummNode*, bool> >& flag_log) const {
+
+    for(const std::pair<SummNode*, bool>& flag : flags) {
+        flag.first->unsummarized = flag.second;
+    }
+
+    flag_log.insert(flag_log.end(), flags.begin(), flags.end());
+}
+
 //SummNode
 
+SummNode::SummNode()
+    : summarizer(0), parent(0), words(0), refs(0), delimiters(0), unsummarized(false), terminal(false) {
+}
+
 SummNode::SummNode(Summarizer* summarizer)
-    : summarizer(summarizer), parent(0), c('*'), words(0), refs(0), delimiter(false), delimiters(0) {
+    : summarizer(summarizer), parent(0), label("*"), words(0), refs(0), delimiters(0), unsummarized(false), terminal(false) {
 }
 
-SummNode::SummNode(Summarizer* summarizer, SummNode* parent, const std::string& str, size_t offset)
-    : summarizer(summarizer), parent(parent), c(str[offset]), words(0), refs(0), delimiter(false), delimiters(0) {
+std::string SummNode::toString() const {
+
+    std::string str;
 
-    if(summarizer->isDelimiter(c)) {
-        delimiter = true;
-        delimiters++;
+    for(const SummNode* node = this; node->parent != 0; node = node->parent) {
+        str.insert(0, node->label);
     }
 
-    //if leaf
-    if(!addWord(str, ++offset)) {
-        words=1;
+    return str;
+}
+
+// delimiters at or after the first character of the label
+int SummNode::getLeadingDelimiters() const {
+
+    int count = delimiters;
+
+    for(size_t i=0; i+1 < label.size(); i++) {
+        if(summarizer->isDelimiter(label[i])) count++;
     }
+
+    return count;
 }
 
-SummNode::~SummNode() {
-    for(SummNode* child : children) {
-        delete child;
+SummCacheEntry* SummNode::getCacheEntry(const SummQuery& query, int max_rows, int depth) {
+
+    for(SummCacheEntry& entry : cache) {
+        if(entry.matches(query, max_rows, depth)) return &entry;
     }
+
+    return 0;
 }
 
-std::string SummNode::toString() const {
+SummCacheEntry& SummNode::addCacheEntry(const SummQuery& query, int max_rows, int depth) {
 
-    const SummNode* node = this;
+    // replace the oldest entry
+    if(cache.size() >= SUMM_NODE_CACHE_SIZE) {
+        cache.erase(cache.begin());
+    }
 
-    std::string str;
+    cache.push_back(SummCacheEntry(query, max_rows, depth));
 
-    do {
-        str.append(1, node->c);
-        node = node->parent;
-    } while(node->parent != 0);
+    return cache.back();
+}
 
-    std::reverse(str.begin(), str.end());
+// discard cached summaries of this node and its ancestors
+void SummNode::invalidate() {
+    for(SummNode* node = this; node != 0; node = node->parent) {
+        node->cache.clear();
+    }
+}
 
-    return str;
+// split after the first length characters of the label, returning the new parent node
+SummNode* SummNode::split(size_t length) {
+
+    ASSERT(length > 0 && length < label.size());
+
+    SummNode* upper = summarizer->createNode(parent, label, 0, length);
+
+    // all strings through the first part continue into the remainder
+    upper->refs  = refs;
+    upper->words = refs;
+    upper->unsummarized = unsummarized;
+
+    std::replace(parent->children.begin(), parent->children.end(), this, upper);
+
+    upper->children.push_back(this);
+    parent = upper;
+
+    label.erase(0, length);
+
+    invalidate();
+
+    upper->delimiters = getLeadingDelimiters();
+
+    if(summarizer->isDelimiter(upper->label.back())) {
+        upper->delimiters++;
+    }
+
+    return upper;
+}
+
+// true if no strings end at this node and it has one child
+bool SummNode::canMerge() const {
+    return parent != 0 && !terminal && children.size() == 1 && children[0]->refs == refs;
+}
+
+// join the only child on to the end of this node
+void SummNode::merge() {
+
+    SummNode* child = children[0];
+
+    label     += child->label;
+    words      = child->words;
+    delimiters = child->delimiters;
+    terminal   = child->terminal;
+
+    children.swap(child->children);
+    child->children.clear();
+
+    for(SummNode* grandchild : children) {
+        grandchild->parent = this;
+    }
+
+    cache.clear();
+
+    summarizer->releaseNode(child);
 }
 
-bool SummNode::removeWord(const std::string& str, size_t offset) {
+// remove count of a string added at least count times.
+// returns the number of delimiters removed
+int SummNode::removeWord(const std::string& str, size_t offset, int count) {
 
-    refs--;
+    refs -= count;
+
+    cache.clear();
 
     size_t str_size = str.size() - offset;
 
-    if(!str_size) return false;
+    if(!str_size) return 0;
 
-    words--;
+    words -= count;
 
-    // BUG: this never actually gets set to true, though nothing uses it
-    bool removed = false;
+    int removed = 0;
 
     for(auto it = children.begin(); it != children.end(); it++) {
 
         SummNode* child = *it;
 
-        if(child->c == str[offset]) {
-            delimiters -= child->delimiters;
+        if(child->label[0] == str[offset]) {
+
+            int child_delimiters = child->getLeadingDelimiters();
 
-            removed = child->removeWord(str,++offset);
+            child->removeWord(str, offset + child->label.size(), count);
 
             if(child->refs == 0) {
                 children.erase(it);
-                delete child;
+                summarizer->releaseNode(child);
+
+                removed = child_delimiters;
             } else {
-                delimiters += child->delimiters;
+                while(child->canMerge()) child->merge();
+
+                removed = child_delimiters - child->getLeadingDelimiters();
             }
 
             break;
         }
     }
 
+    delimiters -= removed;
+
     return removed;
 }
 
-bool SummNode::addWord(const std::string& str, size_t offset) {
+// add count of a string.
+// returns the number of delimiters added
+int SummNode::addWord(const std::string& str, size_t offset, int count) {
+
+    refs += count;
 
-    refs++;
+    cache.clear();
 
     size_t str_size = str.size() - offset;
 
-    if(!str_size) return false;
+    if(!str_size) return 0;
 
-    words++;
+    words += count;
+
+    char c = str[offset];
 
     for(SummNode* child : children) {
-        char c = str[offset];
 
-        if(child->c == c) {
+        if(child->label[0] != c) continue;
 
-            int old_child_delimeters = child->delimiters;
+        size_t max_length = std::min(child->label.size(), str_size);
+        size_t length = 1;
 
-            if(child->addWord(str, ++offset)) {
-                // update delimiter count
+        while(length < max_length && child->label[length] == str[offset+length]) length++;
 
-                delimiters -= old_child_delimeters;
-                delimiters += child->delimiters;
+        if(length < child->label.size()) {
+            child = child->split(length);
+        }
 
-//                if(delimiters > 0) {
-//                    debugLog("%d delimiters", delimiters);
-//                }
+        int added = child->addWord(str, offset + length, count);
 
-                return true;
-            }
+        delimiters += added;
 
-            return false;
-        }
+        return added;
+    }
+
+    // leaf holding the rest of the string
+    SummNode* child = summarizer->createNode(this, str, offset);
+
+    child->refs     = count;
+    child->words    = 1;
+    child->terminal = true;
+
+    if(summarizer->isDelimiter(child->label.back())) {
+        child->delimiters = 1;
     }
 
-    SummNode* child = new SummNode(summarizer, this, str, offset);
     children.push_back(child);
 
-    delimiters += child->delimiters;
+    int added = child->getLeadingDelimiters();
 
-    return true;
+    delimiters += added;
+
+    return added;
 }
 
 void SummNode::debug(int indent) const {
@@ -216,7 +345,7 @@ void SummNode::debug(int indent) const {
     std::string indentation;
     if(indent>0) indentation.append(indent, ' ');
 
-    debugLog("%snode c=%c refs=%d words=%d delims=%d", indentation.c_str(), c, refs, words, delimiters);
+    debugLog("%snode label=%s refs=%d words=%d delims=%d", indentation.c_str(), label.c_str(), refs, words, delimiters);
 
     indent++;
 
@@ -225,31 +354,157 @@ void SummNode::debug(int indent) const {
     }
 }
 
-std::string SummNode::formatNode(std::string str, int refs) {
+//SummNodePool
+
+SummNodePool::SummNodePool() : block_index(0), block_used(0) {
+}
+
+SummNodePool::~SummNodePool() {
+    for(SummNode* block : blocks) {
+        delete[] block;
+    }
+}
+
+SummNode* SummNodePool::allocate() {
+
+    if(!free_nodes.empty()) {
+        SummNode* node = free_nodes.back();
+        free_nodes.pop_back();
+        return node;
+    }
+
+    if(block_used == SUMM_NODE_BLOCK_SIZE) {
+        block_index++;
+        block_used = 0;
+    }
+
+    if(block_index == blocks.size()) {
+        blocks.push_back(new SummNode[SUMM_NODE_BLOCK_SIZE]);
+    }
+
+    return &blocks[block_index][block_used++];
+}
+
+void SummNodePool::release(SummNode* node) {
+    free_nodes.push_back(node);
+}
+
+//SummChar
+
+SummChar::SummChar() : node(0), offset(0) {
+}
+
+SummChar::SummChar(SummNode* node, size_t offset) : node(node), offset(offset) {
+}
+
+char SummChar::c() const {
+    return node->label[offset];
+}
+
+bool SummChar::isRoot() const {
+    return node->parent == 0;
+}
+
+bool SummChar::isLast() const {
+    return offset+1 == node->label.size();
+}
+
+bool SummChar::isLeaf() const {
+    return isLast() && node->children.empty() && node->parent != 0;
+}
+
+bool SummChar::isDelimiter() const {
+    return node->parent != 0 && node->summarizer->isDelimiter(c());
+}
+
+bool SummChar::hasRootParent() const {
+    return offset == 0 && node->parent != 0 && node->parent->parent == 0;
+}
+
+int SummChar::getWords() const {
+    return isLast() ? node->words : node->refs;
+}
+
+int SummChar::getRefs() const {
+    return node->refs;
+}
+
+// only the first character of a label keeps a flag. the flag of a character
+// part way through a label is only read after its parent is abbreviated,
+// which always leaves it unsummarized
+bool SummChar::isUnsummarized() const {
+    return offset == 0 ? node->unsummarized : true;
+}
+
+void SummChar::setUnsummarized(bool unsummarized) {
+    if(offset != 0) return;
+
+    node->unsummarized = unsummarized;
+    node->summarizer->flag_log.push_back(std::make_pair(node, unsummarized));
+}
+
+void SummChar::getChildren(std::vector<SummChar>& children) const {
+
+    if(!isLast()) {
+        children.push_back(SummChar(node, offset+1));
+        return;
+    }
+
+    children.reserve(node->children.size());
+
+    for(SummNode* child : node->children) {
+        children.push_back(SummChar(child, 0));
+    }
+}
+
+std::string SummChar::formatNode(std::string str, int refs) const {
     char buff[256];
     snprintf(buff, 256, "%03d %s", refs, str.c_str());
 
     return std::string(buff);
 }
 
-void SummNode::expand(std::string prefix, std::vector<std::string>& vec, bool unsummarized_only) {
+// count the rows listed when expanding, recording the children listed
+int SummChar::countExpansion(bool unsummarized_only, std::string& expanded_children) const {
+
+    if(isLast() && node->children.empty()) return 1;
+
+    std::vector<SummChar> children;
+    getChildren(children);
+
+    int count = 0;
+
+    for(SummChar& child : children) {
+        if(unsummarized_only && !child.isUnsummarized()) continue;
 
-    if(children.empty()) {
-        vec.push_back(formatNode(prefix, refs));
+        // for expanded detail don't limit depth
+        SummQuery query(0, 0);
+
+        count += child.countRows(query, 100);
+
+        expanded_children += child.c();
+    }
+
+    return count;
+}
+
+void SummChar::expand(const std::string& prefix, const std::string& expanded_children, std::vector<std::string>& vec) const {
+
+    if(isLast() && node->children.empty()) {
+        vec.push_back(formatNode(prefix, getRefs()));
         return;
     }
 
-    //find top-but-not-root node, expand root node
-    std::vector<SummRow>::iterator it;
+    std::vector<SummChar> children;
+    getChildren(children);
 
-    for(SummNode* child : children) {
-        if(unsummarized_only && !child->unsummarized) continue;
+    for(SummChar& child : children) {
+        if(expanded_children.find(child.c()) == std::string::npos) continue;
 
-        // for expanded detail don't limit depth
         SummQuery query(0, 0);
 
         std::vector<SummRow> strvec;
-        child->summarize(query, strvec, 100);
+        child.summarize(query, strvec, 100);
 
         for(const SummRow& row : strvec) {
             vec.push_back(formatNode(prefix + row.str, row.refs));
@@ -257,26 +512,92 @@ void SummNode::expand(std::string prefix, std::vector<std::string>& vec, bool un
     }
 }
 
-void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth) {
+// summaries of the start of a node are cached, replaying the unsummarized flags set
+// when the summary was made so the flags are the same as summarizing again
+void SummChar::summarize(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth) const {
+
+    if(offset != 0) {
+        summarizeRows(query, output, max_rows, depth);
+        return;
+    }
+
+    std::vector<std::pair<SummNode*, bool> >& flag_log = node->summarizer->flag_log;
+
+    if(SummCacheEntry* entry = node->getCacheEntry(query, max_rows, depth)) {
+        entry->replayFlags(flag_log);
+        output.insert(output.end(), entry->rows.begin(), entry->rows.end());
+        return;
+    }
+
+    size_t first_row  = output.size();
+    size_t first_flag = flag_log.size();
+
+    summarizeRows(query, output, max_rows, depth);
+
+    SummCacheEntry& entry = node->addCacheEntry(query, max_rows, depth);
+
+    entry.rows.assign(output.begin() + first_row, output.end());
+    entry.flags.assign(flag_log.begin() + first_flag, flag_log.end());
+}
+
+// number of rows summarize would return, without copying cached rows
+int SummChar::countRows(const SummQuery& query, int max_rows, int depth) const {
+
+    if(offset == 0) {
+        if(SummCacheEntry* entry = node->getCacheEntry(query, max_rows, depth)) {
+            entry->replayFlags(node->summarizer->flag_log);
+            return entry->rows.size();
+        }
+    }
+
+    std::vector<SummRow> rows;
+    summarize(query, rows, max_rows, depth);
+
+    return rows.size();
+}
+
+void SummChar::summarizeRows(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth) const {
 
     ASSERT(max_rows > 0);
 
-    if(children.empty() && parent != 0) {
-        output.push_back(SummRow(this));
+    // a character part way through a label that is not a delimiter summarizes
+    // to the rows of the next character, skip to the next delimiter or the end of the label
+    if(!isLast() && !isDelimiter()) {
+
+        size_t end = offset + 1;
+
+        while(end+1 < node->label.size() && !node->summarizer->isDelimiter(node->label[end])) end++;
+
+        size_t first_row = output.size();
+
+        SummChar(node, end).summarize(query, output, max_rows, depth);
+
+        for(size_t i=first_row; i<output.size(); i++) {
+            output[i].prepend(node->label.data() + offset, end - offset);
+        }
+
+        return;
+    }
+
+    if(isLeaf()) {
+        output.push_back(SummRow(*this));
         return;
     }
 
+    std::vector<SummChar> children;
+    getChildren(children);
+
     int total_child_words = 0;
-    for(SummNode* child : children) {
-        total_child_words += child->words;
+    for(const SummChar& child : children) {
+        total_child_words += child.getWords();
     }
 
-    std::vector<SummNode*> sorted_children = children;
+    std::vector<SummChar> sorted_children = children;
 
     // word sort
     std::sort(sorted_children.begin(), sorted_children.end(),
-        [](SummNode*a, SummNode*b) {
-            return b->words < a->words;
+        [](const SummChar& a, const SummChar& b) {
+            return b.getWords() < a.getWords();
     });
 
     // pre-pass to determine if we expect there to be
@@ -286,16 +607,18 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
     int child_depth = depth;
 
-    if(delimiter && parent != 0 && parent != summarizer->getRoot()) {
+    bool delimiter = isDelimiter();
+
+    if(delimiter && !hasRootParent()) {
         child_depth++;
 
         if(query.limitMaxDepth() && child_depth >= query.getMaxDepth()) {
 
-            for(SummNode* child : children) {
-                child->unsummarized=true;
+            for(SummChar& child : children) {
+                child.setUnsummarized(true);
             }
 
-            output.push_back(SummRow(this, true));
+            output.push_back(SummRow(*this, true));
             return;
         }
     }
@@ -303,9 +626,9 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
     if(max_rows < sorted_children.size()) {
         expect_unsummarized = true;
     } else {
-        for(SummNode* child : sorted_children) {
+        for(const SummChar& child : sorted_children) {
 
-            float percent = (float) child->words / total_child_words;
+            float percent = (float) child.getWords() / total_child_words;
 
             int child_max_rows = (int)(percent * max_rows);
 
@@ -324,20 +647,20 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
     int spare_rows = 0;
     int children_summarized = 0;
-    std::deque<SummNode*> unsummarized_children;
+    std::deque<SummChar> unsummarized_children;
 
     bool allow_partial_abbreviations = true;
 
-    if(   (delimiter == true || !parent)
+    if(   (delimiter == true || isRoot())
        && (!query.allowAbbreviations() || depth < query.getAbbreviationDepth())) {
         allow_partial_abbreviations = false;
     }
 
     // if we have not reached
 
-    for(SummNode* child : sorted_children) {
+    for(SummChar& child : sorted_children) {
 
-        float percent = (float) child->words / total_child_words;
+        float percent = (float) child.getWords() / total_child_words;
 
         int child_max_rows = (int)(percent * available_rows);
 
@@ -350,7 +673,7 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
         if(child_max_rows > 0) {
 
-            child->summarize(query, child_output, child_max_rows, child_depth);
+            child.summarize(query, child_output, child_max_rows, child_depth);
 
             // discard partially abbreviated rows if not allowed
             if(allow_partial_abbreviations == false) {
@@ -359,14 +682,14 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
                     SummRow& row = *it;
 
-                    if(row.abbreviated && !row.source->delimiter) {
+                    if(row.abbreviated && !row.source.isDelimiter()) {
                         // NOTE: the child gets marked as unsummarized here
                         // though is more likely 'partially summarized'
                         //child->unsummarized = true;
-                        row.source->unsummarized = true;
+                        row.source.setUnsummarized(true);
                         it = child_output.erase(it);
 
-                        //std::string child_row_str = row.source->toString();
+                        //std::string child_row_str = row.source.node->toString();
                         //debugLog("'%s' unsummarized due to partial abbreviation", child_row_str.c_str());
 
                     } else {
@@ -386,17 +709,21 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
         if(child_rows > 0) {
             // NOTE: unsummarized indicates row should appear in the mouse over list
             // of an abbreviated row
-            child->unsummarized = false;
+            child.setUnsummarized(false);
 
             children_summarized++;
 
-            for(size_t j=0; j<child_rows; j++) {
-                if(parent!=0) child_output[j].prependChar(c);
+            if(!isRoot()) {
+                char c = this->c();
+
+                for(size_t j=0; j<child_rows; j++) {
+                    child_output[j].prependChar(c);
+                }
             }
 
-            output.insert(output.end(), child_output.begin(), child_output.end());
+            output.insert(output.end(), std::make_move_iterator(child_output.begin()), std::make_move_iterator(child_output.end()));
         } else {
-            child->unsummarized = true;
+            child.setUnsummarized(true);
             unsummarized_children.push_back(child);
         }
 
@@ -415,10 +742,10 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
         bool abbreviate_self = true;
 
         if(output.size() < max_rows && unsummarized_children.size() == 1) {
-            SummNode* child = unsummarized_children.front();
+            SummChar child = unsummarized_children.front();
 
             std::vector<SummRow> child_output;
-            child->summarize(query, child_output, 1, child_depth);
+            child.summarize(query, child_output, 1, child_depth);
 
             ASSERT(child_output.size()==1);
 
@@ -426,11 +753,11 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
             // add row if we're allowed to use it
             if(   child_row.abbreviated == false
-               || child_row.source->delimiter
+               || child_row.source.isDelimiter()
                || allow_partial_abbreviations) {
-                child->unsummarized = false;
-                if(parent != 0) child_row.prependChar(c);
-                output.push_back(child_row);
+                child.setUnsummarized(false);
+                if(!isRoot()) child_row.prependChar(c());
+                output.push_back(std::move(child_row));
                 abbreviate_self = false;
             }
         }
@@ -443,11 +770,11 @@ void SummNode::summarize(const SummQuery& query, std::vector<SummRow>& output, i
 
             if(output.size() >= max_rows) {
                 SummRow& row = output.back();
-                row.source->unsummarized = true;
+                row.source.setUnsummarized(true);
                 output.pop_back();
             }
 
-            output.push_back(SummRow(this, true));
+            output.push_back(SummRow(*this, true));
         }
     }
 
@@ -462,6 +789,9 @@ SummItem::SummItem(Summarizer* summarizer, SummRow unit)
     pos  = vec2(-1.0f, -1.0f);
     dest = vec2(-1.0f, -1.0f);
 
+    width     = -1;
+    showcount = false;
+
     updateRow(unit);
 
     destroy=false;
@@ -477,21 +807,35 @@ bool SummItem::isMoving() const {
 
 void SummItem::updateRow(const SummRow& unit) {
 
+    // the display string and its width are kept unless something shown in it changed
+    bool reformat = width < 0
+        || showcount != summarizer->showCount()
+        || unit.abbreviated != row.abbreviated
+        || unit.expanded_count != row.expanded_count
+        || (showcount && unit.refs != row.refs)
+        || unit.str != row.str;
+
     this->row = unit;
 
+    expanded.clear();
+
     vec3 col = summarizer->hasColour() ? summarizer->getColour() : colourHash(unit.str);
     this->colour = vec4(col, 1.0f);
 
+    if(!reformat) return;
+
+    showcount = summarizer->showCount();
+
     char buff[1024];
 
     if(unit.abbreviated) {
-        if(summarizer->showCount()) {
-            snprintf(buff, 1024, "%03d %s* (%d)", unit.refs, unit.str.c_str(), (int) unit.expanded.size());
+        if(showcount) {
+            snprintf(buff, 1024, "%03d %s* (%d)", unit.refs, unit.str.c_str(), unit.expanded_count);
         } else {
-            snprintf(buff, 1024, "%s* (%d)", unit.str.c_str(), (int) unit.expanded.size());
+            snprintf(buff, 1024, "%s* (%d)", unit.str.c_str(), unit.expanded_count);
         }
     } else {
-        if(summarizer->showCount()) {
+        if(showcount) {
             snprintf(buff, 1024, "%03d %s", unit.refs, unit.str.c_str());
         } else {
             snprintf(buff, 1024, "%s", unit.str.c_str());
@@ -589,7 +933,14 @@ Summarizer::Summarizer(FXFont font, int screen_percent, int max_depth, int abbre
 }
 
 void Summarizer::clear() {
+
+    for(SummNode* child : root.children) {
+        releaseNode(child);
+    }
+
     root = SummNode(this);
+
+    string_counts.clear();
 }
 
 int Summarizer::getScreenPercent() {
@@ -628,6 +979,40 @@ const SummNode *Summarizer::getRoot() const {
     return &root;
 }
 
+SummNode* Summarizer::createNode(SummNode* parent, const std::string& label, size_t offset, size_t length) {
+
+    SummNode* node = node_pool.allocate();
+
+    node->summarizer = this;
+    node->parent     = parent;
+    node->label.assign(label, offset, length);
+
+    node->words      = 0;
+    node->refs       = 0;
+    node->delimiters = 0;
+
+    node->children.clear();
+    node->unsummarized = false;
+    node->terminal     = false;
+
+    node->cache.clear();
+
+    return node;
+}
+
+// return a node and its descendants to the pool
+void Summarizer::releaseNode(SummNode* node) {
+
+    for(SummNode* child : node->children) {
+        releaseNode(child);
+    }
+
+    node->children.clear();
+    node->cache.clear();
+
+    node_pool.release(node);
+}
+
 void Summarizer::setSize(int x, float top_gap, float bottom_gap) {
     this->pos_x      = x;
     this->title_top  = top_gap;
@@ -659,7 +1044,7 @@ bool Summarizer::mouseOver(const vec2& pos) const {
     return true;
 }
 
-const SummItem* Summarizer::itemAtPos(const vec2& pos) {
+SummItem* Summarizer::itemAtPos(const vec2& pos) {
     for(SummItem& item : items) {
         if(item.departing) continue;
 
@@ -679,10 +1064,12 @@ bool Summarizer::getInfoAtPos(TextArea& textarea, const vec2& pos) {
 
     float y = pos.y;
 
-    const SummItem* item = itemAtPos(pos);
+    SummItem* item = itemAtPos(pos);
 
     if(item != 0) {
-        textarea.setText(item->row.expanded);
+        if(item->expanded.empty() && !expandRow(item->row, item->expanded)) return false;
+
+        textarea.setText(item->expanded);
         textarea.setColour(vec3(item->colour));
         textarea.setPos(pos);
 
@@ -788,17 +1175,20 @@ void Summarizer::summarize() {
     changed = false;
 
     strings.clear();
+    flag_log.clear();
 
     SummQuery query(prefix_filter.empty() ? max_depth : 0, abbreviation_depth);
 
-    root.summarize(query, strings, max_strings);
+    SummChar(&root, 0).summarize(query, strings, max_strings);
 
     size_t nostrs = strings.size();
 
     for(size_t i=0;i<nostrs;i++) {
-        strings[i].buildSummary();
+        strings[i].countExpanded();
     }
 
+    flag_log.clear();
+
     std::sort(strings.begin(), strings.end(), Summarizer::row_sorter);
     
     if(nostrs>1) {
@@ -819,34 +1209,35 @@ void Summarizer::recalc_display() {
 
     size_t nostrs = strings.size();
 
+    row_index.clear();
+
+    for(size_t i=0;i<nostrs;i++) {
+        row_index.insert(std::make_pair(boost::string_view(strings[i].str), i));
+    }
+
     std::vector<bool> strfound;
     strfound.resize(nostrs, false);
 
-    size_t found_count = 0;
-    
     //update summItems
     for(SummItem& item : items) {
 
-        int match = -1;
+        auto it = row_index.find(boost::string_view(item.row.str));
 
-        for(size_t j=0;j<nostrs;j++) {
-            const SummRow& summstr = strings[j];
+        if(it == row_index.end()) {
+            item.setDeparting(true);
+            continue;
+        }
 
-            if(summstr.str.compare(item.row.str) == 0) {
-                item.updateRow(summstr);
+        size_t match = it->second;
 
-                match = (int)j;
+        item.updateRow(strings[match]);
+        strfound[match] = true;
 
-                strfound[j]= true;
-                found_count++;
-                
-                break;
-            }
-        }
-
-        item.setDeparting(match == -1 ? true : false);
+        item.setDeparting(false);
     }
 
+    size_t item_count = items.size();
+
     //add items for strings not found
     for(size_t i=0;i<nostrs;i++) {
         if(strfound[i]) continue;
@@ -855,9 +1246,13 @@ void Summarizer::recalc_display() {
         
         //debugLog("added item for unit %s %d", strings[i].str.c_str(), items[items.size()-1].destroy);
     }
-    
-    // sort items alphabetically
-    std::sort(items.begin(), items.end(), Summarizer::item_sorter);
+
+    // sort items alphabetically.
+    // existing items are still in order so only the added items need sorting
+    if(items.size() > item_count) {
+        std::sort(items.begin() + item_count, items.end(), Summarizer::item_sorter);
+        std::inplace_merge(items.begin(), items.begin() + item_count, items.end(), Summarizer::item_sorter);
+    }
 
     // set y positions
 
@@ -886,84 +1281,321 @@ void Summarizer::recalc_display() {
     }
 }
 
-void Summarizer::removeString(const std::string& str) {
-    root.removeWord(str,0);
+void Summarizer::removeString(const InternedString& str, int count) {
+
+    // ignore strings not in the tree
+    auto it = string_counts.find(str);
+
+    if(it == string_counts.end()) return;
+
+    count = std::min(count, it->second);
+
+    if(count <= 0) return;
+
+    it->second -= count;
+
+    if(it->second == 0) string_counts.erase(it);
+
+    root.removeWord(str.str(),0,count);
     changed = true;
 }
 
+void Summarizer::removeString(const std::string& str, int count) {
+    removeString(intern_table.intern(str), count);
+}
+
 float Summarizer::calcPosY(int i) const {
     return top_gap + (incrementf * i) ;
 }
 
-const SummNode* Summarizer::getMatchingNode(const std::string& input) const {
+// find the character at the end of a string, the root for an empty string
+bool Summarizer::findChar(const std::string& str, SummChar& position) {
 
-    if(input.empty()) return 0;
+    SummNode* node = &root;
 
-    int index = 0;
-    const SummNode* node = &root;
+    if(str.empty()) {
+        position = SummChar(node, 0);
+        return true;
+    }
+
+    size_t index = 0;
 
-    do {
-        const SummNode* matching_node = 0;
+    while(true) {
+        SummNode* matching_node = 0;
 
         for(SummNode* child : node->children) {
-            if(child->c == input[index]) {
+            if(child->label[0] == str[index]) {
                 matching_node = child;
                 break;
             }
         }
 
-        node = 0;
+        if(matching_node == 0) return false;
 
-        if(matching_node != 0) {
-            node = matching_node;
+        size_t max_length = std::min(matching_node->label.size(), str.size() - index);
+        size_t length = 1;
 
-            if(index == input.size()-1) {
-                return node;
-            }
+        while(length < max_length && matching_node->label[length] == str[index+length]) length++;
+
+        if(length < matching_node->label.size() && index + length < str.size()) return false;
+
+        index += length;
 
-            index++;
+        if(index == str.size()) {
+            position = SummChar(matching_node, length-1);
+            return true;
         }
 
-    } while(node != 0);
+        node = matching_node;
+    }
+}
+
+// find the node ending at the input, splitting a node if the input ends part way through its label
+SummNode* Summarizer::getMatchingNode(const std::string& input) {
 
-    return node;
+    if(input.empty()) return 0;
+
+    SummChar position;
+
+    if(!findChar(input, position)) return 0;
+
+    if(!position.isLast()) {
+        return position.node->split(position.offset+1);
+    }
+
+    return position.node;
 }
 
-int Summarizer::getBestMatchIndex(const std::string& input) const {
+// list the strings summarized by a row from the current tree
+bool Summarizer::expandRow(const SummRow& row, std::vector<std::string>& expansion) {
 
-    int best_diff = -1;
-    int best      = -1;
-    int best_size = -1;
+    expansion.clear();
+
+    SummChar source;
+
+    if(!findChar(row.str, source)) return false;
+
+    source.expand(row.str, row.expanded_children, expansion);
+
+    flag_log.clear();
+
+    return !expansion.empty();
+}
+
+// length of the common prefix of a string and the first length characters of another
+static size_t summ_common_prefix(const std::string& a, const std::string& b, size_t length) {
+
+    size_t max_length = std::min(a.size(), length);
+
+    size_t i = 0;
+    while(i < max_length && a[i] == b[i]) i++;
+
+    return i;
+}
+
+// first row in [first, last) not less than the first length characters of str
+static size_t summ_lower_bound(const std::vector<SummRow>& rows, size_t first, size_t last, const std::string& str, size_t length) {
+
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+
+        if(rows[middle].str.compare(0, std::string::npos, str, 0, length) < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+// first row in [first, last) greater than the first length characters of str
+static size_t summ_upper_bound(const std::vector<SummRow>& rows, size_t first, size_t last, const std::string& str, size_t length) {
+
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+
+        if(rows[middle].str.compare(0, std::string::npos, str, 0, length) <= 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+// end of the rows from first which start with the first length characters of str
+static size_t summ_prefix_end(const std::vector<SummRow>& rows, size_t first, size_t last, const std::string& str, size_t length) {
+
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+
+        if(rows[middle].str.compare(0, length, str, 0, length) == 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+// longest row in [first, last) which is a prefix of the first length characters of str.
+// a prefix is not greater than str, and if the greatest row that is not greater is not a prefix,
+// any prefix must also be a prefix of the part of str it has in common
+static int summ_longest_prefix(const std::vector<SummRow>& rows, size_t first, size_t last, const std::string& str, size_t length) {
+
+    while(true) {
+        last = summ_upper_bound(rows, first, last, str, length);
+
+        if(last == first) return -1;
+
+        const std::string& row_str = rows[last-1].str;
+
+        size_t common = summ_common_prefix(row_str, str, length);
+
+        if(common == row_str.size()) return last-1;
+
+        last--;
+        length = common;
+    }
+}
+
+// Rows are sorted as non-numeric then numeric strings, each run in string order.
+//
+// Matches the result of comparing the input to each row in order, preferring the lowest
+// difference of the first differing character, or a row with a prefix in common (difference 0).
+// When tied, a later row shorter than the input replaces the best row if it has
+// more characters in common with the input.
+//
+// Rows with a prefix in common are either prefixes of the input or start with it. Within a run
+// prefixes come first, so if the first of these rows is a prefix, the longest prefix is the best.
+// Otherwise the rows with the same common prefix length are contiguous either side of the input
+// with the closest character at the end nearest the input.
+int Summarizer::getBestMatchIndex(const std::string& input) const {
 
     size_t nostrs = strings.size();
 
-    for(size_t i = 0;i < nostrs; i++) {
+    if(!nostrs) return -1;
 
-        size_t strn_size  = strings[i].str.size();
-        size_t input_size = input.size();
+    size_t input_size = input.size();
 
-        int size_diff = strn_size - input_size;
+    size_t numeric_start = std::partition_point(strings.begin(), strings.end(),
+        [](const SummRow& row) {
+            return atoi(row.str.c_str()) == 0;
+    }) - strings.begin();
 
-        size_t min_size   = size_diff == 0 ? input_size : std::min ( strn_size, input_size );
+    size_t run_start[2] = { 0, numeric_start };
+    size_t run_end[2]   = { numeric_start, nostrs };
+    size_t input_pos[2];
 
-        int min_common_diff = abs( strings[i].str.compare(0, min_size, input, 0, min_size) );
+    for(int r=0; r<2; r++) {
+        input_pos[r] = summ_lower_bound(strings, run_start[r], run_end[r], input, input_size);
 
         //found
-        if(size_diff == 0 && min_common_diff == 0) {
-            best = i;
-            break;
+        if(input_pos[r] < run_end[r] && strings[input_pos[r]].str == input) {
+            return input_pos[r];
         }
+    }
+
+    // rows with a prefix in common
 
-        if(    best_diff == -1
-            || min_common_diff < best_diff
-            || (min_common_diff == best_diff //remove this?
-               && min_size > best_size
-               && strn_size < input_size)) {
+    int first_common   = -1;
+    int longest_prefix = -1;
+    bool first_is_prefix = false;
 
-            best = i;
+    for(int r=0; r<2; r++) {
 
-            best_diff = min_common_diff;
-            best_size = min_size;
+        int prefix = summ_longest_prefix(strings, run_start[r], input_pos[r], input, input_size);
+
+        bool extends = input_pos[r] < run_end[r] && strings[input_pos[r]].str.compare(0, input_size, input) == 0;
+
+        if(first_common == -1) {
+            if(prefix != -1) {
+                first_common    = prefix;
+                first_is_prefix = true;
+            } else if(extends) {
+                first_common = input_pos[r];
+            }
+        }
+
+        if(prefix != -1 && (longest_prefix == -1 || strings[prefix].str.size() > strings[longest_prefix].str.size())) {
+            longest_prefix = prefix;
+        }
+    }
+
+    if(first_common != -1) {
+        return first_is_prefix ? longest_prefix : first_common;
+    }
+
+    // ranges of rows with the lowest difference
+
+    int best_diff = -1;
+    std::vector<std::pair<size_t, size_t> > ranges;
+
+    for(int r=0; r<2; r++) {
+
+        // rows before the input
+
+        size_t end = input_pos[r];
+
+        while(end > run_start[r]) {
+            const std::string& row_str = strings[end-1].str;
+
+            size_t common = summ_common_prefix(row_str, input, input_size);
+            size_t first  = summ_lower_bound(strings, run_start[r], end, input, common);
+
+            int diff = (unsigned char) input[common] - (unsigned char) row_str[common];
+
+            if(best_diff == -1 || diff <= best_diff) {
+                if(diff != best_diff) ranges.clear();
+
+                best_diff = diff;
+                ranges.push_back(std::make_pair(summ_lower_bound(strings, first, end, row_str, common+1), end));
+            }
+
+            end = first;
+        }
+
+        // rows after the input
+
+        size_t start = input_pos[r];
+
+        while(start < run_end[r]) {
+            const std::string& row_str = strings[start].str;
+
+            size_t common = summ_common_prefix(row_str, input, input_size);
+            size_t last   = summ_prefix_end(strings, start, run_end[r], input, common);
+
+            int diff = (unsigned char) row_str[common] - (unsigned char) input[common];
+
+            if(best_diff == -1 || diff <= best_diff) {
+                if(diff != best_diff) ranges.clear();
+
+                best_diff = diff;
+                ranges.push_back(std::make_pair(start, summ_prefix_end(strings, start, last, row_str, common+1)));
+            }
+
+            start = last;
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+
+    int best      = -1;
+    int best_size = -1;
+
+    for(const std::pair<size_t, size_t>& range : ranges) {
+        for(size_t i = range.first; i < range.second; i++) {
+
+            size_t strn_size = strings[i].str.size();
+            int min_size     = std::min(strn_size, input_size);
+
+            if(best == -1 || (min_size > best_size && strn_size < input_size)) {
+                best      = i;
+                best_size = min_size;
+            }
         }
     }
 
@@ -1032,11 +1664,19 @@ FXFont& Summarizer::getFont() {
     return font;
 }
 
-void Summarizer::addString(const std::string& str) {
-    root.addWord(str,0);
+void Summarizer::addString(const InternedString& str, int count) {
+    if(count <= 0) return;
+
+    string_counts[str] += count;
+
+    root.addWord(str.str(),0,count);
     changed = true;
 }
 
+void Summarizer::addString(const std::string& str, int count) {
+    addString(intern_table.intern(str), count);
+}
+
 void Summarizer::addDelimiter(char c) {
     delimiters.push_back(c);
 }
@@ -1078,3 +1718,57 @@ void Summarizer::draw(float dt, float alpha) {
     }
 
 }
+
+// SummBatch
+
+SummBatchString::SummBatchString(Summarizer* summarizer, const InternedString& str, int count)
+    : summarizer(summarizer), str(str), count(count) {
+}
+
+size_t SummBatchHash::operator()(const std::pair<Summarizer*, int>& key) const {
+    return std::hash<Summarizer*>()(key.first) ^ ((size_t) key.second * 2654435761u);
+}
+
+SummBatch::SummBatch() {
+}
+
+bool SummBatch::empty() const {
+    return strings.empty();
+}
+
+void SummBatch::add(Summarizer* summarizer, const InternedString& str, int count) {
+
+    auto it = index.find(std::make_pair(summarizer, str.getId()));
+
+    if(it != index.end()) {
+        strings[it->second].count += count;
+        return;
+    }
+
+    index[std::make_pair(summarizer, str.getId())] = strings.size();
+    strings.push_back(SummBatchString(summarizer, str, count));
+}
+
+// add the strings in the order they were first seen
+void SummBatch::addStrings() {
+
+    for(SummBatchString& batch_string : strings) {
+        batch_string.summarizer->addString(batch_string.str, batch_string.count);
+    }
+
+    clear();
+}
+
+void SummBatch::removeStrings() {
+
+    for(SummBatchString& batch_string : strings) {
+        batch_string.summarizer->removeString(batch_string.str, batch_string.count);
+    }
+
+    clear();
+}
+
+void SummBatch::clear() {
+    strings.clear();
+    index.clear();
+}
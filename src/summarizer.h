@@ -23,28 +23,76 @@
 #include "core/regex.h"
 
 #include "textarea.h"
+#include "interntable.h"
+
+#define SUMM_NODE_BLOCK_SIZE 256
+#define SUMM_NODE_CACHE_SIZE 4
 
 extern const char* summ_wildcard;
 
 class SummNode;
+class SummRow;
+class SummQuery;
 class Summarizer;
 
+// a character in the tree, the node holding it and its offset in the node's label.
+// characters before the end of a label have a single child, the next character
+
+class SummChar {
+public:
+    SummNode* node;
+    size_t offset;
+
+    SummChar();
+    SummChar(SummNode* node, size_t offset);
+
+    char c() const;
+
+    bool isRoot() const;
+    bool isLast() const;
+    bool isLeaf() const;
+    bool isDelimiter() const;
+    bool hasRootParent() const;
+
+    int getWords() const;
+    int getRefs() const;
+
+    bool isUnsummarized() const;
+    void setUnsummarized(bool unsummarized);
+
+    void getChildren(std::vector<SummChar>& children) const;
+
+    int countExpansion(bool unsummarized_only, std::string& expanded_children) const;
+    void expand(const std::string& prefix, const std::string& expanded_children, std::vector<std::string>& expansion) const;
+
+    void summarize(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth = 0) const;
+    int  countRows(const SummQuery& query, int max_rows, int depth = 0) const;
+protected:
+    void summarizeRows(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth) const;
+
+    std::string formatNode(std::string str, int refs) const;
+};
+
 class SummRow {
 public:
     SummRow();
-    SummRow(SummNode* source, bool abbreviated = false);
+    SummRow(const SummChar& source, bool abbreviated = false);
 
-    SummNode* source;
+    SummChar source;
 
     int words;
     int refs;
     std::string str;
     bool abbreviated;
 
-    std::vector<std::string> expanded;
+    // number of rows listed when hovering over the row and
+    // the first character of each child they are listed from
+    int expanded_count;
+    std::string expanded_children;
 
     void prependChar(char c);
-    void buildSummary();
+    void prepend(const char* str, size_t length);
+    void countExpanded();
 };
 
 class SummQuery {
@@ -59,37 +107,89 @@ public:
 
     int getMaxDepth() const;
     int getAbbreviationDepth() const;
+
+    bool operator==(const SummQuery& other) const;
 };
 
+// rows from summarizing a node and the unsummarized flags set doing so,
+// reused until a string passing through the node is added or removed
+
+class SummCacheEntry {
+public:
+    SummCacheEntry(const SummQuery& query, int max_rows, int depth);
+
+    SummQuery query;
+    int max_rows;
+    int depth;
+
+    std::vector<SummRow> rows;
+    std::vector<std::pair<SummNode*, bool> > flags;
+
+    bool matches(const SummQuery& query, int max_rows, int depth) const;
+
+    void replayFlags(std::vector<std::pair<SummNode*, bool> >& flag_log) const;
+};
+
+// node of a path compressed tree of strings. a node holds a run of characters
+// passed through by the same strings, refs, words and delimiters are the counts
+// of the last character of the label
+
 class SummNode {
 public:
     Summarizer* summarizer;
     SummNode* parent;
 
+    SummNode();
     SummNode(Summarizer* summarizer);
-    SummNode(Summarizer* summarizer, SummNode* parent, const std::string& str, size_t offset);
-    ~SummNode();
 
-    char c;
+    std::string label;
+
     int words;
     int refs;
     int delimiters;
 
     std::vector<SummNode*> children;
     bool unsummarized;
-    bool delimiter;
+
+    // the node was created by a string ending at it
+    bool terminal;
+
+    std::vector<SummCacheEntry> cache;
 
     void debug(int indent = 0) const;
-    bool addWord(const std::string& str, size_t offset);
-    bool removeWord(const std::string& str, size_t offset);
 
-    void expand(std::string prefix, std::vector<std::string>& expansion, bool unsummarized_only);
+    SummCacheEntry* getCacheEntry(const SummQuery& query, int max_rows, int depth);
+    SummCacheEntry& addCacheEntry(const SummQuery& query, int max_rows, int depth);
+
+    void invalidate();
+
+    int  addWord(const std::string& str, size_t offset, int count = 1);
+    int  removeWord(const std::string& str, size_t offset, int count = 1);
 
-    void summarize(const SummQuery& query, std::vector<SummRow>& output, int max_rows, int depth = 0);
+    int getLeadingDelimiters() const;
+
+    SummNode* split(size_t length);
+
+    bool canMerge() const;
+    void merge();
 
     std::string toString() const;
-protected:
-    std::string formatNode(std::string str, int refs);
+};
+
+// allocates nodes in blocks. released nodes are reused
+
+class SummNodePool {
+    std::vector<SummNode*> blocks;
+    std::vector<SummNode*> free_nodes;
+
+    size_t block_index;
+    size_t block_used;
+public:
+    SummNodePool();
+    ~SummNodePool();
+
+    SummNode* allocate();
+    void release(SummNode* node);
 };
 
 class SummItem {
@@ -101,6 +201,9 @@ class SummItem {
 
     float elapsed;
     float eta;
+
+    // showCount() when the display string was formatted
+    bool showcount;
 public:
     SummItem(Summarizer* summarizer, SummRow row);
 
@@ -112,6 +215,9 @@ public:
 
     SummRow row;
 
+    // built on first hover
+    std::vector<std::string> expanded;
+
     vec4 colour;
     vec2 pos;
 
@@ -128,12 +234,25 @@ public:
 };
 
 class Summarizer {
+    friend class SummChar;
 protected:
     std::vector<SummRow> strings;
 
     std::vector<SummItem> items;
+
+    // index of each row in strings by its string
+    std::unordered_map<boost::string_view, size_t, InternTableHash> row_index;
+
+    SummNodePool node_pool;
     SummNode root;
 
+    // number of times each string was added, by interned id. strings
+    // not in the tree are skipped without walking it
+    std::unordered_map<InternedString, int, InternedStringHash> string_counts;
+
+    // unsummarized flags set during the current summarize
+    std::vector<std::pair<SummNode*, bool> > flag_log;
+
     vec3 item_colour;
     bool has_colour;
 
@@ -168,7 +287,10 @@ protected:
     static bool row_sorter(const SummRow &a, const SummRow &b);
     static bool item_sorter(const SummItem &a, const SummItem &b);
 
-    const SummItem* itemAtPos(const vec2 &pos);
+    SummItem* itemAtPos(const vec2 &pos);
+
+    bool findChar(const std::string& str, SummChar& position);
+    bool expandRow(const SummRow& row, std::vector<std::string>& expansion);
 
     void updateDisplayTitle();
 public:
@@ -183,6 +305,9 @@ public:
     const std::string& getTitle() const;
     const SummNode* getRoot() const;
 
+    SummNode* createNode(SummNode* parent, const std::string& label, size_t offset = 0, size_t length = std::string::npos);
+    void releaseNode(SummNode* node);
+
     void setSize(int x, float top_gap, float bottom_gap);
     bool isAnimating() const;
 
@@ -213,13 +338,16 @@ public:
     bool supportedString(const std::string& str);
     bool matchesPrefixFilter(const std::string& str) const;
 
-    void removeString(const std::string& str);
-    void addString(const std::string& str);
+    void removeString(const InternedString& str, int count = 1);
+    void addString(const InternedString& str, int count = 1);
+
+    void removeString(const std::string& str, int count = 1);
+    void addString(const std::string& str, int count = 1);
 
     void addDelimiter(char c);
     bool isDelimiter(char c) const;
 
-    const SummNode* getMatchingNode(const std::string& input) const;
+    SummNode* getMatchingNode(const std::string& input);
     const std::string& getBestMatchStr(const std::string& str) const;
     int         getBestMatchIndex(const std::string& str) const;
     float       getPosY(const std::string& str) const;
@@ -236,4 +364,39 @@ public:
     void draw(float dt, float alpha);
 };
 
+// a string to add to or remove from a summarizer count times
+
+class SummBatchString {
+public:
+    SummBatchString(Summarizer* summarizer, const InternedString& str, int count);
+
+    Summarizer* summarizer;
+    InternedString str;
+    int count;
+};
+
+class SummBatchHash {
+public:
+    size_t operator()(const std::pair<Summarizer*, int>& key) const;
+};
+
+// strings collected to be added to or removed from summarizers together.
+// equal interned strings are counted so each distinct string is only walked through a tree once
+
+class SummBatch {
+    std::vector<SummBatchString> strings;
+    std::unordered_map<std::pair<Summarizer*, int>, size_t, SummBatchHash> index;
+public:
+    SummBatch();
+
+    bool empty() const;
+
+    void add(Summarizer* summarizer, const InternedString& str, int count = 1);
+
+    void addStrings();
+    void removeStrings();
+
+    void clear();
+};
+
 #endif
@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "summarizerpool.h"
+
+#include <algorithm>
+
+SummarizerPool::SummarizerPool(int thread_count) : pending(0), running(true) {
+
+    if(thread_count < 0) thread_count = getDefaultThreadCount();
+
+    for(int i=0;i<thread_count;i++) {
+        threads.push_back(std::thread(&SummarizerPool::run, this));
+    }
+}
+
+SummarizerPool::~SummarizerPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    work_cond.notify_all();
+
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+int SummarizerPool::getDefaultThreadCount() {
+    //the calling thread does its share so leave a core for it
+    int cores = std::thread::hardware_concurrency();
+
+    return std::max(0, std::min(cores - 1, SUMMARIZER_POOL_MAX_THREADS));
+}
+
+int SummarizerPool::getThreadCount() const {
+    return threads.size();
+}
+
+//worker thread
+void SummarizerPool::run() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true) {
+
+        while(running && work.empty()) {
+            work_cond.wait(lock);
+        }
+
+        if(!running) break;
+
+        summarizeNext(lock);
+    }
+}
+
+//summarize the next queued summarizer with the lock released
+void SummarizerPool::summarizeNext(std::unique_lock<std::mutex>& lock) {
+
+    Summarizer* summarizer = work.front();
+    work.pop_front();
+
+    lock.unlock();
+
+    summarizer->summarize();
+
+    lock.lock();
+
+    if(--pending == 0) done_cond.notify_all();
+}
+
+void SummarizerPool::summarize(const std::vector<Summarizer*>& summarizers) {
+
+    if(threads.empty() || summarizers.size() < 2) {
+        for(Summarizer* summarizer : summarizers) {
+            summarizer->summarize();
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for(Summarizer* summarizer : summarizers) {
+        work.push_back(summarizer);
+    }
+
+    pending += summarizers.size();
+
+    work_cond.notify_all();
+
+    while(!work.empty()) {
+        summarizeNext(lock);
+    }
+
+    while(pending > 0) {
+        done_cond.wait(lock);
+    }
+}
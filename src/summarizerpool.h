@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2019 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUMMARIZER_POOL_H
+#define SUMMARIZER_POOL_H
+
+#include "summarizer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SUMMARIZER_POOL_MAX_THREADS 4
+
+// summarizes a set of summarizers concurrently on a pool of worker threads.
+// summarizers share no state while summarizing, so each can be summarized by any thread.
+// the calling thread also takes summarizers and returns once all of them are done
+
+class SummarizerPool {
+    std::mutex mutex;
+    std::condition_variable work_cond;
+    std::condition_variable done_cond;
+
+    std::deque<Summarizer*> work;
+    size_t pending;
+
+    bool running;
+
+    std::vector<std::thread> threads;
+
+    void run();
+    void summarizeNext(std::unique_lock<std::mutex>& lock);
+public:
+    SummarizerPool(int thread_count = -1);
+    ~SummarizerPool();
+
+    static int getDefaultThreadCount();
+
+    int getThreadCount() const;
+
+    void summarize(const std::vector<Summarizer*>& summarizers);
+};
+
+#endif
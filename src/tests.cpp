@@ -1,8 +1,23 @@
 #include "tests.h"
 #include "summarizer.h"
+#include "requestwindow.h"
+#include "requestball.h"
 #include "settings.h"
+#include "ncsa.h"
+#include "logreader.h"
+#include "jsonlog.h"
+#include "linescanner.h"
+#include "mappedlog.h"
+#include "compressedlog.h"
 #include "core/regex.h"
 
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <zlib.h>
+
 #define test(name,assertion,expected) if((assertion)!=(expected)) {\
     char error[1024];\
     snprintf(error, 1024, "test '%s' failed at %s:%d", name, __FILE__, __LINE__);\
@@ -14,6 +29,72 @@ LogstalgiaTester::LogstalgiaTester()
 
 }
 
+// compare every field of two log entries
+static bool entriesMatch(const LogEntry& a, const LogEntry& b) {
+
+    if(a.timestamp != b.timestamp) return false;
+    if(a.response_size != b.response_size) return false;
+    if(a.successful != b.successful) return false;
+
+    const std::vector<std::string>& fields = LogEntry::getFields();
+
+    for(const std::string& field : fields) {
+        std::string a_value, b_value;
+
+        if(a.getValue(field, a_value) != b.getValue(field, b_value)) return false;
+        if(a_value != b_value) return false;
+    }
+
+    return true;
+}
+
+// log of lines held in memory, read as if from a stream
+class TestLog : public BaseLog {
+    std::vector<std::string> lines;
+    size_t next_line;
+public:
+    TestLog(const std::vector<std::string>& lines) : lines(lines), next_line(0) {}
+
+    bool getNextLine(std::string& line) {
+        if(next_line >= lines.size()) return false;
+        line = lines[next_line++];
+        return true;
+    }
+
+    bool isFinished() {
+        return next_line >= lines.size();
+    }
+};
+
+// best match by comparing the input to each row in turn, as the summarizer did before
+// the rows were searched. prefers the lowest difference at the first differing character
+static int linearBestMatchIndex(const std::vector<std::string>& rows, const std::string& input) {
+
+    int best_diff = -1;
+    int best      = -1;
+    int best_size = -1;
+
+    for(size_t i=0; i<rows.size(); i++) {
+
+        const std::string& row = rows[i];
+
+        size_t min_size = std::min(row.size(), input.size());
+        size_t common   = std::mismatch(row.begin(), row.begin() + min_size, input.begin()).first - row.begin();
+
+        int diff = common < min_size ? abs((int) (unsigned char) row[common] - (int) (unsigned char) input[common]) : 0;
+
+        if(row.size() == input.size() && diff == 0) return i;
+
+        if(best_diff == -1 || diff < best_diff || (diff == best_diff && (int) min_size > best_size && row.size() < input.size())) {
+            best      = i;
+            best_diff = diff;
+            best_size = min_size;
+        }
+    }
+
+    return best;
+}
+
 void LogstalgiaTester::runTests() {
 
     FXFont font = fontmanager.grab("FreeMonoBold.ttf", settings.font_size, 72, FT_LOAD_NO_HINTING);
@@ -193,4 +274,733 @@ void LogstalgiaTester::runTests() {
 
     images_node = image_summarizer->getMatchingNode("/images/");
     test("/images/ node no longer found", images_node == 0, true);
+
+    // strings added and removed with a count
+
+    image_summarizer->addString("/images/cat.jpg", 3);
+    image_summarizer->addString("/images/cat.png");
+
+    cat_jpg_node = image_summarizer->getMatchingNode("/images/cat.jpg");
+    test("/images/cat.jpg node found", cat_jpg_node != 0, true);
+    test("/images/cat.jpg refs is 3",  cat_jpg_node->refs, 3);
+    test("/images/cat.jpg words is 1", cat_jpg_node->words, 1);
+
+    images_node = image_summarizer->getMatchingNode("/images/");
+    test("/images/ refs is 4",  images_node->refs, 4);
+    test("/images/ words is 4", images_node->words, 4);
+
+    image_summarizer->removeString("/images/cat.jpg", 2);
+
+    cat_jpg_node = image_summarizer->getMatchingNode("/images/cat.jpg");
+    test("/images/cat.jpg refs is 1", cat_jpg_node->refs, 1);
+
+    // removing more than were added removes the rest
+    image_summarizer->removeString("/images/cat.jpg", 5);
+
+    cat_jpg_node = image_summarizer->getMatchingNode("/images/cat.jpg");
+    test("/images/cat.jpg no longer found", cat_jpg_node == 0, true);
+
+    images_node = image_summarizer->getMatchingNode("/images/");
+    test("/images/ refs is 1", images_node->refs, 1);
+
+    // batches add and remove each distinct string once with its count
+
+    InternedString cat_jpg = intern_table.intern("/images/cat.jpg");
+    InternedString dog_jpg = intern_table.intern("/images/dog.jpg");
+
+    SummBatch batch;
+
+    batch.add(image_summarizer, cat_jpg);
+    batch.add(image_summarizer, dog_jpg);
+    batch.add(image_summarizer, cat_jpg);
+    batch.add(image_summarizer, cat_jpg);
+
+    batch.addStrings();
+
+    test("batch empty after adding", batch.empty(), true);
+
+    cat_jpg_node = image_summarizer->getMatchingNode("/images/cat.jpg");
+    test("/images/cat.jpg refs is 3", cat_jpg_node->refs, 3);
+
+    dog_jpg_node = image_summarizer->getMatchingNode("/images/dog.jpg");
+    test("/images/dog.jpg refs is 1", dog_jpg_node->refs, 1);
+
+    batch.add(image_summarizer, cat_jpg);
+    batch.add(image_summarizer, cat_jpg);
+    batch.add(image_summarizer, dog_jpg);
+
+    batch.removeStrings();
+
+    cat_jpg_node = image_summarizer->getMatchingNode("/images/cat.jpg");
+    test("/images/cat.jpg refs is 1", cat_jpg_node->refs, 1);
+
+    dog_jpg_node = image_summarizer->getMatchingNode("/images/dog.jpg");
+    test("/images/dog.jpg no longer found", dog_jpg_node == 0, true);
+
+    image_summarizer->removeString("/images/cat.jpg");
+    image_summarizer->removeString("/images/cat.png");
+
+    images_node = image_summarizer->getMatchingNode("/images/");
+    test("/images/ node no longer found", images_node == 0, true);
+
+    // searching the summary for the best match must agree with comparing against every row
+
+    Summarizer host_summarizer(font, percent, 2, 1, update_rate, ".*", "HOST");
+    host_summarizer.addDelimiter('.');
+    host_summarizer.setSize(0, 0, 0);
+
+    const char* hosts[] = { "www.example.com", "mail.example.com", "example.org", "cdn.example.net", "a.b.c.d" };
+
+    for(int i=0; i<200; i++) {
+        char ip[32];
+        snprintf(ip, 32, "%d.%d.%d.%d", 10 + i % 3, i % 7, (i * 13) % 256, i);
+        host_summarizer.addString(ip);
+        host_summarizer.addString(hosts[i % 5]);
+    }
+
+    host_summarizer.summarize();
+    host_summarizer.getSummary(summary);
+
+    test("host summary is not empty", summary.empty(), false);
+
+    std::vector<std::string> queries;
+
+    for(const std::string& row : summary) {
+        queries.push_back(row);
+        queries.push_back(row.substr(0, row.size() / 2));
+        queries.push_back(row + "x");
+        queries.push_back(row + ".9");
+    }
+
+    for(int i=0; i<5; i++) queries.push_back(hosts[i]);
+
+    const char* misses[] = { "", "-", "0", "9.9.9.9", "10.", "11.6.200", "12.99.1.1", "255.255.255.255", "www", "zzz.example.com", "\xff" };
+
+    for(const char* miss : misses) queries.push_back(miss);
+
+    for(const std::string& query : queries) {
+        test("best match agrees with linear search", host_summarizer.getBestMatchIndex(query), linearBestMatchIndex(summary, query));
+    }
+
+    // request ball tests
+
+    RequestBalls balls;
+
+    std::vector<LogEntry*> ball_entries;
+
+    for(int i=0;i<3;i++) {
+        LogEntry* le = new LogEntry();
+        le->response_size = 1000;
+        le->successful    = true;
+
+        balls.add(le, InternedString(), vec3(1.0f, 1.0f, 1.0f), vec2(-10.0f - i * 100.0f, 100.0f), vec2(500.0f, 100.0f));
+        ball_entries.push_back(le);
+    }
+
+    // the last ball takes the place of a removed ball
+    balls.remove(0);
+
+    test("ball removed", balls.size(), 2);
+    test("last ball moved to removed index", balls.getLogEntry(0), ball_entries[2]);
+    test("other ball unchanged", balls.getLogEntry(1), ball_entries[1]);
+    test("moved ball keeps its path", balls.getFinishPos(0).y, 100.0f);
+
+    size_t nearest_ball = 0;
+
+    test("nearest ball found", balls.findNearest(InternedString(), nearest_ball), true);
+    test("nearest ball", balls.getLogEntry(nearest_ball), ball_entries[1]);
+
+    InternedString vhost_token = intern_table.intern("www.example.com");
+
+    test("no balls heading to paddle", balls.findNearest(vhost_token, nearest_ball), false);
+
+    LogEntry* vhost_entry = new LogEntry();
+    vhost_entry->response_size = 1000;
+    vhost_entry->successful    = true;
+
+    balls.add(vhost_entry, vhost_token, vec3(1.0f, 1.0f, 1.0f), vec2(-500.0f, 100.0f), vec2(500.0f, 100.0f));
+
+    test("nearest ball of paddle found", balls.findNearest(vhost_token, nearest_ball), true);
+    test("nearest ball of paddle", balls.getLogEntry(nearest_ball), vhost_entry);
+
+    balls.remove(1);
+
+    test("nearest ball after removal", balls.findNearest(InternedString(), nearest_ball), true);
+    test("nearest ball after removal", balls.getLogEntry(nearest_ball), ball_entries[2]);
+    test("moved ball still heading to paddle", balls.findNearest(vhost_token, nearest_ball), true);
+    test("moved ball still heading to paddle", balls.getLogEntry(nearest_ball), vhost_entry);
+    test("moved ball keeps its paddle token", balls.getPaddleToken(nearest_ball), vhost_token);
+
+    balls.clear();
+
+    // request window tests
+
+    RequestWindow request_window(3);
+
+    InternedString window_path = intern_table.intern("/window.html");
+    InternedString window_host = intern_table.intern("10.0.0.1");
+    InternedString other_host  = intern_table.intern("10.0.0.2");
+
+    std::vector<RequestWindowEntry> expired;
+
+    request_window.advance(1000, expired);
+
+    request_window.add(image_summarizer, window_path, window_host);
+    request_window.add(image_summarizer, window_path, window_host);
+    request_window.add(image_summarizer, window_path, other_host);
+
+    request_window.advance(1001, expired);
+
+    request_window.add(image_summarizer, window_path, window_host);
+
+    std::vector<RequestWindowEntry*> window_entries;
+    request_window.getEntries(window_entries);
+
+    test("equal requests counted together", window_entries.size(), 3);
+    test("added request counted in its group", window_entries[2]->in_group, true);
+    test("added request counted in hostnames", window_entries[2]->in_hosts, true);
+
+    // a request isn't merged into an entry a refilter left out of a summarizer
+    window_entries[2]->in_hosts = false;
+
+    request_window.add(image_summarizer, window_path, window_host);
+
+    window_entries.clear();
+    request_window.getEntries(window_entries);
+
+    test("refiltered entry not merged into", window_entries.size(), 4);
+
+    if(window_entries.size() == 4) {
+        test("refiltered entry count", window_entries[2]->count, 1);
+        test("refiltered entry still left out", window_entries[2]->in_hosts, false);
+        test("request after refilter counted in hostnames", window_entries[3]->in_hosts, true);
+
+        // merged into the newer entry
+        request_window.add(image_summarizer, window_path, window_host);
+        test("request after refilter merged", window_entries[3]->count, 2);
+    }
+
+    request_window.advance(1002, expired);
+    test("requests within the window kept", expired.empty(), true);
+
+    request_window.advance(1003, expired);
+    test("requests of the first second expired", expired.size(), 2);
+    test("expired request count", expired[0].count, 2);
+    test("expired request hostname", expired[0].hostname.str(), "10.0.0.1");
+    test("expired request count", expired[1].count, 1);
+
+    expired.clear();
+
+    // moving further than the window expires everything
+    request_window.advance(1100, expired);
+    test("remaining requests expired", expired.size(), 2);
+
+    window_entries.clear();
+    request_window.getEntries(window_entries);
+    test("window is empty", window_entries.empty(), true);
+
+    // ncsa parser tests
+
+    NCSALog ncsalog;
+
+    LogEntry clf_entry;
+    std::string clf_line = "127.0.0.1 - - [22/Apr/2009:18:52:51 +1200] \"GET /images/cat.jpg HTTP/1.1\" 200 2326";
+
+    test("parsed common log format line", ncsalog.parseLine(clf_line, clf_entry), true);
+    test("expected hostname",      clf_entry.hostname.str(), "127.0.0.1");
+    test("expected vhost",         clf_entry.vhost.str(), "");
+    test("expected timestamp",     clf_entry.timestamp, 1240383171);
+    test("expected method",        clf_entry.method, "GET");
+    test("expected path",          clf_entry.path.str(), "/images/cat.jpg");
+    test("expected protocol",      clf_entry.protocol, "HTTP/1.1");
+    test("expected response code", clf_entry.response_code, "200");
+    test("expected response size", clf_entry.response_size, 2326);
+
+    LogEntry combined_entry;
+    std::string combined_line = "www.example.com 127.0.0.1 - frank [22/Apr/2009:18:52:51 -0130] \"POST /login HTTP/1.0\" 302 - \"http://www.example.com/\" \"Mozilla/5.0 (X11)\" \"1234\"";
+
+    test("parsed combined log format line", ncsalog.parseLine(combined_line, combined_entry), true);
+    test("expected hostname",   combined_entry.hostname.str(), "127.0.0.1");
+    test("expected vhost",      combined_entry.vhost.str(), "www.example.com");
+    test("expected timestamp",  combined_entry.timestamp, 1240383171 + 12*3600 + 90*60);
+    test("expected referrer",   combined_entry.referrer, "http://www.example.com/");
+    test("expected user agent", combined_entry.user_agent, "Mozilla/5.0 (X11)");
+    test("expected pid",        combined_entry.pid.str(), "1234");
+
+    // tokenizer must produce the same entries as the regular expression parser for the lines
+    // it accepts, and leave lines it can't handle to the regular expression parser
+
+    std::vector<std::pair<std::string, bool> > ncsa_lines = {
+        { clf_line, true },
+        { combined_line, true },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +1200] \"GET / HTTP/1.1\" 304 0 \"-\" \"curl/7.64.0\"", true },
+        { "127.0.0.1 - - [22/04/2009:18:52:51 +0000] \"GET /index.html HTTP/1.1\" 200 512 \"-\" \"curl/7.64.0\" 5678 extra", true },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +0000]  \"GET  /a%20b  HTTP/1.1\"  404  17  \"-\"  \"-\"", true },
+        { "127.0.0.1 - - [22/apr/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0", true },
+        { "127.0.0.1 - - [22/Foo/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0", true },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0 \"\" \"\" \"\"", true },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0 \"http://example.com/\"", true },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +0000] \"-\" 400 0 \"-\" \"-\"", false },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51 +0000] \"GET /\" 200 0", false },
+        { "127.0.0.1 - - [22/13/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0", false },
+        { "127.0.0.1 - - [22/Apr/2009:18:52:51] \"GET / HTTP/1.1\" 200 0", false },
+        { "127.0.0.1 [22/Apr/2009:18:52:51 +0000] \"GET / HTTP/1.1\" 200 0", false },
+        { "not a log entry", false }
+    };
+
+    for(auto& ncsa_line : ncsa_lines) {
+        std::string& line = ncsa_line.first;
+
+        LogEntry tokenized_entry;
+        LogEntry regex_entry;
+
+        bool tokenized = ncsalog.tokenizeLine(line, tokenized_entry);
+        bool regex     = ncsalog.parseLineRegex(line, regex_entry);
+
+        test("tokenizer accepts expected lines", tokenized, ncsa_line.second);
+
+        if(tokenized) {
+            tokenized_entry.setSuccess();
+            tokenized_entry.setResponseColour();
+
+            test("regex parser accepts tokenized lines", regex, true);
+            test("tokenized entry valid", tokenized_entry.validate(), true);
+            test("tokenizer and regex parser entries match", entriesMatch(tokenized_entry, regex_entry), true);
+        }
+
+        // rejected lines must parse exactly as the regular expression parser parses them
+        LogEntry parsed_entry;
+        bool parsed = ncsalog.parseLine(line, parsed_entry);
+
+        test("parser falls back to regex parser", parsed, regex);
+
+        if(parsed) {
+            test("parsed and regex parser entries match", entriesMatch(parsed_entry, regex_entry), true);
+        }
+    }
+
+    // interned fields
+
+    LogEntry repeated_entry;
+    ncsalog.parseLine(clf_line, repeated_entry);
+
+    test("equal hostnames share an id",   repeated_entry.hostname.getId(), clf_entry.hostname.getId());
+    test("equal paths are equal",         repeated_entry.path == clf_entry.path, true);
+    test("different paths are not equal", repeated_entry.path == combined_entry.path, false);
+    test("empty vhost has id 0",          repeated_entry.vhost.getId(), 0);
+
+    InternedString interned = intern_table.intern("/interned/test/path");
+    size_t unique_count = intern_table.getUniqueCount();
+
+    test("interned string value", interned.str(), "/interned/test/path");
+
+    interned = InternedString();
+
+    test("released string removed", intern_table.getUniqueCount(), unique_count - 1);
+
+    // entries share the line buffer, copies must be unaffected by reuse of the original
+
+    LogEntry copied_entry = combined_entry;
+
+    ncsalog.parseLine(clf_line, combined_entry);
+
+    test("copied entry vhost unchanged",    copied_entry.vhost.str(), "www.example.com");
+    test("copied entry referrer unchanged", copied_entry.referrer, "http://www.example.com/");
+    test("reused entry has no referrer",    combined_entry.referrer, "");
+    test("reused entry path",               combined_entry.path.str(), "/images/cat.jpg");
+
+    // fields are views of the one stored copy of the line
+
+    settings.display_log_entry = true;
+
+    LogEntry viewed_entry;
+    ncsalog.parseLine(combined_line, viewed_entry);
+
+    settings.display_log_entry = false;
+
+    const char* line_start = viewed_entry.log_entry.data();
+    const char* line_end   = line_start + viewed_entry.log_entry.size();
+
+    test("stored log entry",            viewed_entry.log_entry, combined_line);
+    test("method within stored line",   viewed_entry.method.data() >= line_start && viewed_entry.method.data() < line_end, true);
+    test("referrer within stored line", viewed_entry.referrer.data() >= line_start && viewed_entry.referrer.data() < line_end, true);
+    test("user agent within stored line", viewed_entry.user_agent.data() >= line_start && viewed_entry.user_agent.data() < line_end, true);
+
+    // the scheme and hostname of absolute urls are removed from the summarized path when hidden
+
+    std::string proxy_line = "127.0.0.1 - - [22/Apr/2009:18:52:51 +1200] \"GET http://www.example.com/images/cat.jpg HTTP/1.1\" 200 2326";
+
+    LogEntry proxy_entry;
+    ncsalog.parseLine(proxy_line, proxy_entry);
+
+    test("absolute url path",          proxy_entry.path.str(), "http://www.example.com/images/cat.jpg");
+    test("absolute url summarized",    proxy_entry.display_path.str(), "http://www.example.com/images/cat.jpg");
+    test("relative url summarized",    clf_entry.display_path.str(), "/images/cat.jpg");
+
+    settings.hide_url_prefix = true;
+
+    ncsalog.parseLine(proxy_line, proxy_entry);
+
+    test("absolute url path unchanged", proxy_entry.path.str(), "http://www.example.com/images/cat.jpg");
+    test("absolute url prefix hidden",  proxy_entry.display_path.str(), "/images/cat.jpg");
+
+    ncsalog.parseLine(clf_line, proxy_entry);
+
+    test("relative url unchanged",      proxy_entry.display_path.str(), "/images/cat.jpg");
+
+    settings.hide_url_prefix = false;
+
+    // parse pipeline must return entries in log order, skipping unparsable lines
+
+    std::vector<std::string> pipeline_lines;
+
+    char pipeline_line[256];
+
+    for(int i=0;i<5000;i++) {
+        if(i % 100 == 7) {
+            pipeline_lines.push_back("not a log entry");
+            continue;
+        }
+
+        snprintf(pipeline_line, 256, "10.0.%d.%d - - [22/Apr/2009:18:%02d:%02d +1200] \"GET /page/%d HTTP/1.1\" 200 %d", (i / 256) % 256, i % 256, (i / 60) % 60, i % 60, i, i);
+        pipeline_lines.push_back(pipeline_line);
+    }
+
+    TestLog pipeline_log(pipeline_lines);
+    LogReader logreader(&pipeline_log, "", 3);
+
+    size_t pipeline_index = 0;
+    bool pipeline_ordered = true;
+
+    LogEntry* pipeline_entry;
+
+    while((pipeline_entry = logreader.getNextEntry(true)) != 0) {
+
+        while(pipeline_index < pipeline_lines.size() && pipeline_lines[pipeline_index] == "not a log entry") pipeline_index++;
+
+        LogEntry expected_entry;
+
+        if(pipeline_index >= pipeline_lines.size()
+           || !ncsalog.parseLine(pipeline_lines[pipeline_index], expected_entry)
+           || !entriesMatch(*pipeline_entry, expected_entry)) {
+            pipeline_ordered = false;
+        }
+
+        pipeline_index++;
+
+        delete pipeline_entry;
+    }
+
+    test("pipeline entries in log order",  pipeline_ordered, true);
+    test("pipeline read every line",       pipeline_index, pipeline_lines.size());
+
+    AccessLog* pipeline_format = logreader.createAccessLog();
+    test("pipeline detected ncsa format",  dynamic_cast<NCSALog*>(pipeline_format) != 0, true);
+    delete pipeline_format;
+
+    test("pipeline counted unparsed lines", logreader.getFailedLineCount(), 50);
+
+    // format detection goes with the format most of the sample parses as, not the first line
+
+    std::vector<std::string> detection_lines = { "1240383171|127.0.0.1|/custom|200|100" };
+
+    for(int i=0;i<20;i++) {
+        detection_lines.push_back(clf_line);
+    }
+
+    TestLog detection_log(detection_lines);
+    LogReader detection_reader(&detection_log, "", 1);
+
+    int detection_count = 0;
+
+    while((pipeline_entry = detection_reader.getNextEntry(true)) != 0) {
+        detection_count++;
+        delete pipeline_entry;
+    }
+
+    test("detection chose ncsa format", detection_count, 20);
+    test("detection counted custom line as unparsed", detection_reader.getFailedLineCount(), 1);
+
+    // json parser tests
+
+    JSONLog jsonlog;
+
+    LogEntry nginx_entry;
+    std::string nginx_line = "{\"time\":\"2009-04-22T18:52:51+12:00\",\"remote_addr\":\"127.0.0.1\",\"request\":\"GET /images/cat.jpg HTTP/1.1\",\"status\":200,\"body_bytes_sent\":2326,\"http_user_agent\":\"Mozilla \\\"5.0\\\"\"}";
+
+    test("parsed nginx json line", jsonlog.parseLine(nginx_line, nginx_entry), true);
+    test("expected hostname",      nginx_entry.hostname.str(), "127.0.0.1");
+    test("expected timestamp",     nginx_entry.timestamp, 1240383171);
+    test("expected method",        nginx_entry.method, "GET");
+    test("expected path",          nginx_entry.path.str(), "/images/cat.jpg");
+    test("expected protocol",      nginx_entry.protocol, "HTTP/1.1");
+    test("expected response code", nginx_entry.response_code, "200");
+    test("expected response size", nginx_entry.response_size, 2326);
+    test("expected user agent",    nginx_entry.user_agent, "Mozilla \"5.0\"");
+
+    LogEntry envoy_entry;
+    std::string envoy_line = "{\"start_time\":\"2009-04-22T06:52:51.123Z\",\"method\":\"POST\",\"path\":\"/login\",\"response_code\":302,\"downstream_remote_address\":\"10.0.0.1:51234\",\"authority\":\"www.example.com\",\"upstream\":{\"cluster\":[\"a\",\"b\"]},\"user_agent\":null}";
+
+    test("parsed envoy json line", jsonlog.parseLine(envoy_line, envoy_entry), true);
+    test("expected hostname without port", envoy_entry.hostname.str(), "10.0.0.1");
+    test("expected vhost",      envoy_entry.vhost.str(), "www.example.com");
+    test("expected timestamp",  envoy_entry.timestamp, 1240383171);
+    test("expected path",       envoy_entry.path.str(), "/login");
+    test("expected no user agent", envoy_entry.user_agent, "");
+
+    std::string json_missing_path = "{\"time\":1240383171,\"remote_addr\":\"127.0.0.1\"}";
+    std::string json_unterminated = "{\"time\":1240383171,\"remote_addr\":\"127.0.0.1\",\"uri\":\"/";
+
+    LogEntry json_entry;
+    test("json line without path rejected", jsonlog.parseLine(json_missing_path, json_entry), false);
+    test("unterminated json line rejected", jsonlog.parseLine(json_unterminated, json_entry), false);
+    test("ncsa line rejected by json parser", jsonlog.parseLine(clf_line, json_entry), false);
+
+    // configured keys replace the default keys of a field
+
+    settings.json_fields.push_back(std::make_pair("hostname", "client"));
+
+    JSONLog mapped_jsonlog;
+    std::string mapped_line = "{\"time\":1240383171,\"remote_addr\":\"127.0.0.1\",\"client\":\"10.0.0.2\",\"uri\":\"/\"}";
+
+    test("parsed mapped json line", mapped_jsonlog.parseLine(mapped_line, json_entry), true);
+    test("expected mapped hostname", json_entry.hostname.str(), "10.0.0.2");
+
+    settings.json_fields.clear();
+
+    // line scanner tests
+
+    std::string filter_line = "GET /caf\xc3\xa9 HTTP/1.1 \t\r ";
+    filter_line.resize(LineScanner::filterLine(&filter_line[0], filter_line.size()));
+
+    test("high bit characters replaced and whitespace trimmed", filter_line, "GET /caf?? HTTP/1.1");
+
+    std::string whitespace_line = " \t \r\n";
+    test("whitespace line filtered to nothing", LineScanner::filterLine(&whitespace_line[0], whitespace_line.size()), 0);
+
+    // vector and scalar scanning agree on lines spanning register boundaries
+
+    for(size_t length = 0; length < 100; length++) {
+        for(size_t content = 0; content <= length; content += 7) {
+            std::string line(length, ' ');
+
+            for(size_t i=0; i<content; i++) {
+                line[i] = (i % 5 == 0) ? (char) (0x80 + i) : (i % 3 == 0) ? '\t' : 'a' + (i % 26);
+            }
+
+            if(length > 0) line[(length * 3) / 4] = '\n';
+
+            std::string scalar_line = line;
+
+            test("vector filter length matches scalar", LineScanner::filterLine(&line[0], length), LineScanner::filterLineScalar(&scalar_line[0], length));
+            test("vector filter matches scalar", line, scalar_line);
+            test("vector line end matches scalar", LineScanner::findLineEnd(line.data(), length), LineScanner::findLineEndScalar(line.data(), length));
+        }
+    }
+
+    // memory mapped log tests
+
+    std::string mapped_path = "logstalgia-test.log";
+
+    {
+        std::ofstream mapped_file(mapped_path.c_str(), std::ios::binary);
+
+        for(int i=0;i<1000;i++) {
+            mapped_file << "line " << i << "\n";
+        }
+
+        mapped_file << "last";
+    }
+
+    MappedLog* mappedlog = MappedLog::open(mapped_path);
+
+#ifndef _WIN32
+    test("mapped log file", mappedlog != 0, true);
+#endif
+
+    if(mappedlog != 0) {
+        std::string mapped_line;
+        int mapped_count = 0;
+
+        while(mappedlog->getNextLine(mapped_line)) {
+            if(mapped_count < 1000) test("expected mapped line", mapped_line, "line " + std::to_string(mapped_count));
+            mapped_count++;
+        }
+
+        test("read all mapped lines", mapped_count, 1001);
+        test("last mapped line without newline", mapped_line, "last");
+        test("mapped log finished", mappedlog->isFinished(), true);
+        test("mapped log at end", mappedlog->getPercent(), 1.0f);
+
+        mappedlog->seekTo(0.5f);
+
+        std::string seek_line;
+        test("read line after seeking", mappedlog->getNextLine(seek_line), true);
+        test("seeked to the start of a line", seek_line.find("line "), 0);
+
+        float seek_percent = mappedlog->getPercent();
+
+        test("peek at line", mappedlog->getNextLineAt(mapped_line, 0.25f), true);
+        test("peeked at the start of a line", mapped_line.find("line "), 0);
+        test("peeking keeps read position", mappedlog->getPercent(), seek_percent);
+
+        test("read line after peeking", mappedlog->getNextLine(mapped_line), true);
+        test("read the line after the seeked line", mapped_line, "line " + std::to_string(atoi(seek_line.c_str() + 5) + 1));
+
+        test("no line to peek at the end", mappedlog->getNextLineAt(mapped_line, 1.0f), false);
+
+        delete mappedlog;
+    }
+
+    // reads past the end of a file truncated while mapped end the log instead of faulting
+
+    {
+        std::ofstream mapped_file(mapped_path.c_str(), std::ios::binary);
+
+        for(int i=0;i<100000;i++) {
+            mapped_file << "line " << i << "\n";
+        }
+    }
+
+    mappedlog = MappedLog::open(mapped_path);
+
+    if(mappedlog != 0) {
+        std::string mapped_line;
+
+        test("read line before truncating", mappedlog->getNextLine(mapped_line), true);
+
+        std::ofstream(mapped_path.c_str(), std::ios::binary | std::ios::trunc);
+
+        test("no line to peek after truncating", mappedlog->getNextLineAt(mapped_line, 0.5f), false);
+        test("no line to read after truncating", mappedlog->getNextLine(mapped_line), false);
+        test("truncated mapped log finished", mappedlog->isFinished(), true);
+
+        delete mappedlog;
+    }
+
+    remove(mapped_path.c_str());
+
+    // compressed log tests
+
+    // several checkpoint spans of lines in two concatenated gzip members,
+    // padded with digits so the output is split over many deflate blocks
+
+    std::string compressed_path = "logstalgia-test.log.gz";
+
+    std::vector<std::string> compressed_lines;
+
+    unsigned int padding_seed = 1;
+
+    for(int i=0;i<120000;i++) {
+        std::string compressed_line = "line " + std::to_string(i) + " ";
+
+        for(int j=0;j<40;j++) {
+            padding_seed = padding_seed * 1103515245 + 12345;
+            compressed_line += (char) ('0' + (padding_seed >> 16) % 10);
+        }
+
+        compressed_lines.push_back(compressed_line);
+    }
+
+    for(int member=0;member<2;member++) {
+        gzFile compressed_file = gzopen(compressed_path.c_str(), member == 0 ? "wb" : "ab");
+
+        size_t half = compressed_lines.size() / 2;
+
+        for(size_t i = member * half; i < (member + 1) * half; i++) {
+            gzprintf(compressed_file, "%s\n", compressed_lines[i].c_str());
+        }
+
+        gzclose(compressed_file);
+    }
+
+    remove((compressed_path + ".lsidx").c_str());
+
+    // the second pass reads the index saved by the first instead of building it
+
+    for(int pass=0;pass<2;pass++) {
+        CompressedLog* compressedlog = CompressedLog::open(compressed_path);
+
+        test("opened gzip compressed log", compressedlog != 0, true);
+
+        if(pass == 1) test("loaded compressed log index", compressedlog->isIndexed(), true);
+
+        std::string compressed_line;
+        size_t compressed_count = 0;
+        bool compressed_match = true;
+
+        while(compressedlog->getNextLine(compressed_line)) {
+            if(compressed_count >= compressed_lines.size() || compressed_line != compressed_lines[compressed_count]) compressed_match = false;
+            compressed_count++;
+        }
+
+        test("expected decompressed lines", compressed_match, true);
+        test("read all compressed lines", compressed_count, compressed_lines.size());
+        test("compressed log finished", compressedlog->isFinished(), true);
+
+        while(!compressedlog->isIndexed()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        test("compressed log has checkpoints", compressedlog->getCheckpointCount() > 2, true);
+
+        // seeking and peeking restore the nearest checkpoint, reading on across the second member
+
+        float compressed_percents[] = { 0.1f, 0.3f, 0.49f, 0.5f, 0.7f, 0.9f };
+
+        for(float compressed_percent : compressed_percents) {
+
+            compressedlog->seekTo(compressed_percent);
+
+            test("read compressed line after seeking", compressedlog->getNextLine(compressed_line), true);
+            test("seeked to the start of a compressed line", compressed_line.find("line "), 0);
+
+            size_t seek_index = atoi(compressed_line.c_str() + 5);
+
+            test("seeked to an expected line", seek_index < compressed_lines.size() && compressed_line == compressed_lines[seek_index], true);
+            test("seeked near the position", std::abs((float) seek_index / compressed_lines.size() - compressed_percent) < 0.05f, true);
+
+            std::string peek_line;
+            float peek_percent = 1.0f - compressed_percent;
+
+            test("peek at compressed line", compressedlog->getNextLineAt(peek_line, peek_percent), true);
+
+            size_t peek_index = atoi(peek_line.c_str() + 5);
+
+            test("peeked at an expected line", peek_line.find("line ") == 0 && peek_index < compressed_lines.size() && peek_line == compressed_lines[peek_index], true);
+            test("peeked near the position", std::abs((float) peek_index / compressed_lines.size() - peek_percent) < 0.05f, true);
+
+            compressed_count = seek_index + 1;
+            compressed_match = true;
+
+            while(compressedlog->getNextLine(compressed_line)) {
+                if(compressed_count >= compressed_lines.size() || compressed_line != compressed_lines[compressed_count]) compressed_match = false;
+                compressed_count++;
+            }
+
+            test("peeking keeps compressed read position", compressed_match, true);
+            test("read compressed lines to the end", compressed_count, compressed_lines.size());
+        }
+
+        // the reader peeks on its own thread, returning the line once it has been read
+
+        if(pass == 1) {
+            LogReader peek_reader(compressedlog, "", 1);
+
+            std::string reader_line;
+            peek_reader.getNextLineAt(reader_line, 0.5f);
+
+            while(peek_reader.isPeeking()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            test("reader peeked at line", peek_reader.getNextLineAt(reader_line, 0.5f), true);
+            test("reader peeked at an expected line", reader_line == compressed_lines[atoi(reader_line.c_str() + 5)], true);
+        }
+
+        delete compressedlog;
+    }
+
+    remove(compressed_path.c_str());
+    remove((compressed_path + ".lsidx").c_str());
 }